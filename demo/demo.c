@@ -17,6 +17,10 @@
 #include "toast.h"
 #include "screen_writer.h"
 #include "shaders.h"
+#include "tasks.h"
+#include "face.h"
+#include "layout.h"
+#include "ui_store.h"
 
 begin_c
 
@@ -25,15 +29,19 @@ static const char* SLIDER2_LABEL = "Slider2: %-3d";
 
 enum {
     FONT_HEIGHT_PT      =  10, // pt = point = 1/72 inch
+    FONT_ATLAS_HEIGHT_PX = 32, // signed distance field glyphs are scaled to any height
     MIN_BUTTON_WIDTH_PT =  60,
     VERTICAL_GAP_PT     =   8,
-    HORIZONTAL_GAP_PT   =   8
+    HORIZONTAL_GAP_PT   =   8,
+    POOL_SIDE           = 100  // pooled canvas: rows x columns of cells
 };
 
 typedef struct {
     app_t a;
-    int font_height_px;
+    int font_height_px; // ui and layout trees were built for
     font_t font;    // default UI font
+    font_t sdf;     // distance field atlas shared by fonts of all sizes
+    font_t* mono;   // glyph cache font: ascii face with symbols face fallback
 //  int program_main;
     texture_t bitmaps[3];
     button_t quit;
@@ -47,6 +55,9 @@ typedef struct {
     ui_t ui_textures;
     ui_t ui_glyphs;
     ui_t ui_ascii;
+    ui_t ui_pool;   // POOL_SIDE pooled rows of POOL_SIDE pooled cells
+    ui_store_t pool;
+    bool pool_marks[POOL_SIDE * POOL_SIDE]; // cells painted by touch
     int  slider1_minimum;
     int  slider1_maximum;
     int  slider1_current;
@@ -56,10 +67,25 @@ typedef struct {
     int  slider2_current;
     char slider2_label[64];
     edit_t edit;
+    struct {
+        layout_t content; // column: textures above the columns
+        layout_t columns; // row of left and right columns
+        layout_t left;    // buttons, checkboxes and ascii
+        layout_t right;   // sliders, glyphs atlas and editor
+        layout_t leaves[10];
+        int count;        // of leaves in use
+    } layout;
 } demo_t;
 
 static inline_c float pt2px(app_t* a, float pt) { return pt * a->xdpi / 72.0f; }
 
+static void layout_leaf(demo_t* d, layout_t* parent, ui_t* u) {
+    assert(d->layout.count < countof(d->layout.leaves));
+    layout_t* l = &d->layout.leaves[d->layout.count++];
+    layout_init(l, LAYOUT_LEAF, u);
+    layout_add(parent, l);
+}
+
 static void init_button(demo_t* d, button_t* b, float x, float y, int key_flags, int key,
                                const char* mnemonic, const char* label, void (*click)(ui_t*)) {
     app_t* a = &d->a;
@@ -117,7 +143,7 @@ static void test(ui_t* u) {
     dc.bblt(&dc, &d->bitmaps[2], 100, 100);
     colorf_t green = *colors.green;
     green.a = 0.75; // translucent
-    dc.luma(&dc, &green, &d->font.atlas, 100, 100);
+    dc.luma(&dc, &green, &d->sdf.atlas, 100, 100);
     dc.rect(&dc, colors.white, 100, 100, w - 200, h - 200, 4);
     float x = w / 2;
     float y = h / 2;
@@ -128,6 +154,10 @@ static void test(ui_t* u) {
     dc.fill(&dc, &c, x - r / 2, y - r / 2, r, r);
     dc.text(&dc, colors.white, &d->font, 500, 500, "Hello World", strlen("Hello World"));
     dc.text(&dc, colors.white, &d->font, 560, 560, "ABC", strlen("ABC"));
+    if (d->mono != null) { // codepoints below 0x20 are only in symbols face
+        const char* symbols = "Symbols: \x13\x16\x19\x1C\x1F";
+        dc.text(&dc, colors.white, d->mono, 500, 620, symbols, strlen(symbols));
+    }
     dc.line(&dc, colors.red, w / 2 - 100, h / 2, w / 2 + 100, h / 2 + 100, 10);
     c = *colors_nc.dirty_gold;  c.a = 0.75;
     dc.line(&dc, &c, 0, 0, w, h, 4);
@@ -148,9 +178,11 @@ static void test(ui_t* u) {
 static bool content_touch(ui_t* u, int touch_action, float x, float y) {
     demo_t* d = (demo_t*)u->a->that;
     bool consumed = false;
-    if ((touch_action & TOUCH_UP) && d->testing) {
+    if ((touch_action & TOUCH_DOWN) && d->testing) {
+        ui.capture(u); // up anywhere ends testing
+    } else if ((touch_action & TOUCH_UP) && d->testing) {
         d->testing = false;
-        sys.invalidate(u->a);
+        ui.invalidate(u);
         consumed = true;
     }
     return consumed;
@@ -174,17 +206,19 @@ static void content_draw(ui_t* u) {
 
 static void glyphs_draw(ui_t* u) {
     demo_t* d = (demo_t*)u->a->that;
-    font_t* f = &d->font;
-    float x = u->x + 0.5;
-    float y = u->y + 0.5;
+    font_t* f = &d->sdf;
+    const rectf_t r = ui.screen_rect(u);
+    float x = r.x + 0.5;
+    float y = r.y + 0.5;
     dc.luma(&dc, colors.white, &f->atlas, x, y);
     u->draw_children(u);
 }
 
 static void ascii_draw(ui_t* u) {
     demo_t* d = (demo_t*)u->a->that;
-    float x = u->x + 0.5;
-    float y = u->y + 0.5;
+    const rectf_t r = ui.screen_rect(u);
+    float x = r.x + 0.5;
+    float y = r.y + 0.5;
     char text[97] = {};
     for (int i = 0; i < 96; i++) { text[i] = 32 + i; }
     screen_writer_t sw = screen_writer(x, y, d->a.theme.font, colors.green);
@@ -196,16 +230,147 @@ static void ascii_draw(ui_t* u) {
 
 static void textures_draw(ui_t* u) {
     demo_t* d = (demo_t*)u->a->that;
-    dc.line(&dc, colors.white, 0.5, 0.5, 0.5, 240 + 2.5, 1);
+    const rectf_t r = ui.screen_rect(u);
+    dc.line(&dc, colors.white, r.x + 0.5, r.y + 0.5, r.x + 0.5, r.y + 240 + 2.5, 1);
     for (int i = 0; i < countof(d->bitmaps); i++) {
         texture_t* b = &d->bitmaps[i];
-        float x = i * (b->w + 1.5);
-        dc.bblt(&dc, b, x + 1.5, 1.5);
-        dc.line(&dc, colors.white, x + b->w + 1.5, 1.5, x + b->w + 1.5, b->h + 1.5, 1.5);
+        float x = r.x + i * (b->w + 1.5);
+        dc.bblt(&dc, b, x + 1.5, r.y + 1.5);
+        dc.line(&dc, colors.white, x + b->w + 1.5, r.y + 1.5, x + b->w + 1.5, r.y + b->h + 1.5, 1.5);
+    }
+    dc.line(&dc, colors.white, r.x + 0.5, r.y + 1.5, r.x + u->w, r.y + 1.5, 1);
+    dc.line(&dc, colors.white, r.x + 0.5, r.y + 240 + 2.5, r.x + u->w, r.y + 240 + 2.5, 1);
+    u->draw_children(u);
+}
+
+// Pooled canvas: 10^4 cells store backed tree. Touch paints a cell and
+// redraws only it. DEBUG build checks store hit tests and draw culling
+// against the pointer tree walk on every touch and draw.
+
+#ifdef DEBUG
+
+static struct {
+    ui_t* walk[POOL_SIDE * (POOL_SIDE + 1)];
+    ui_t* store[POOL_SIDE * (POOL_SIDE + 1)];
+    ui_t* drawn[POOL_SIDE * (POOL_SIDE + 1)];
+    int walk_count;
+    int drawn_count;
+} pool_check;
+
+static void pool_walk_hits(ui_t* u, float x, float y) { // as ui.dispatch_touch() tree walk
+    for (ui_t* c = u->children; c != null; c = c->next) {
+        if (!c->hidden && c->x <= x && x < c->x + c->w && c->y <= y && y < c->y + c->h) {
+            pool_check.walk[pool_check.walk_count++] = c;
+            pool_walk_hits(c, x - c->x, y - c->y);
+        }
+    }
+}
+
+static void pool_walk_visible(ui_t* u, float x, float y, const rectf_t* r, bool drawn) {
+    // x, y of u in the coordinates of r, null r: no clipping,
+    // drawn: draw_children() culling that also draws invalid ui
+    for (ui_t* c = u->children; c != null; c = c->next) {
+        const float cx = x + c->x;
+        const float cy = y + c->y;
+        const bool inside = r == null ||
+            (cx < r->x + r->w && r->x < cx + c->w && cy < r->y + r->h && r->y < cy + c->h);
+        if (!c->hidden && (inside || (drawn && c->invalid))) {
+            if (!drawn || c->children == null) { pool_check.walk[pool_check.walk_count++] = c; }
+            pool_walk_visible(c, cx, cy, r, drawn);
+        }
+    }
+}
+
+static void pool_check_hits(demo_t* d, float x, float y) {
+    pool_check.walk_count = 0;
+    pool_walk_hits(&d->ui_pool, x, y);
+    const int n = ui_store_hits(&d->pool, x, y, pool_check.store, countof(pool_check.store));
+    assertion(n == pool_check.walk_count &&
+              memcmp(pool_check.store, pool_check.walk, n * sizeof(ui_t*)) == 0,
+              "store hits differ from the tree walk at %.1f %.1f", x, y);
+}
+
+static void pool_check_cull(demo_t* d) {
+    const rectf_t r = ui.screen_rect(&d->ui_pool);
+    const rectf_t k = dc.clipping; // absolute
+    const bool clipping = k.w > 0 && k.h > 0;
+    const rectf_t c = clipping ? (rectf_t){k.x - r.x, k.y - r.y, k.w, k.h} : (rectf_t){0, 0, r.w, r.h};
+    pool_check.walk_count = 0;
+    pool_walk_visible(&d->ui_pool, 0, 0, &c, false);
+    const int n = ui_store_cull(&d->pool, c, pool_check.store, countof(pool_check.store));
+    assertion(n == pool_check.walk_count &&
+              memcmp(pool_check.store, pool_check.walk, n * sizeof(ui_t*)) == 0,
+              "store culling differs from the tree walk");
+    pool_check.walk_count = 0; // cells draw_children() is expected to draw
+    pool_walk_visible(&d->ui_pool, r.x, r.y, clipping ? &k : null, true);
+    pool_check.drawn_count = 0;
+}
+
+static void pool_check_drawn() {
+    assertion(pool_check.drawn_count == pool_check.walk_count &&
+              memcmp(pool_check.drawn, pool_check.walk, pool_check.drawn_count * sizeof(ui_t*)) == 0,
+              "drawn cells differ from the tree walk");
+}
+
+#endif
+
+static void pool_cell_draw(ui_t* u) {
+    #ifdef DEBUG
+    pool_check.drawn[pool_check.drawn_count++] = u;
+    #endif
+    if (*(bool*)u->that) {
+        const rectf_t r = ui.screen_rect(u);
+        dc.fill(&dc, colors.orange, r.x, r.y, r.w, r.h);
     }
-    dc.line(&dc, colors.white, 0.5, 1.5, u->w, 1.5, 1);
-    dc.line(&dc, colors.white, 0.5, 240 + 2.5, u->w, 240 + 2.5, 1);
+}
+
+static bool pool_cell_touch(ui_t* u, int touch_action, float x, float y) {
+    if (touch_action & TOUCH_DOWN) {
+        bool* mark = (bool*)u->that;
+        *mark = !*mark;
+        ui.invalidate(u);
+    }
+    return (touch_action & TOUCH_DOWN) != 0;
+}
+
+static bool pool_touch(ui_t* u, int touch_action, float x, float y) {
+    #ifdef DEBUG
+    if (touch_action & TOUCH_DOWN) { pool_check_hits((demo_t*)u->a->that, x, y); }
+    #endif
+    return false;
+}
+
+static void pool_draw(ui_t* u) {
+    const rectf_t r = ui.screen_rect(u);
+    dc.fill(&dc, colors.black, r.x, r.y, r.w, r.h);
+    #ifdef DEBUG
+    pool_check_cull((demo_t*)u->a->that);
+    #endif
     u->draw_children(u);
+    #ifdef DEBUG
+    pool_check_drawn();
+    #endif
+}
+
+static void init_pool(demo_t* d) {
+    const float cell = max(2, (int)(d->font.em / 4));
+    ui.init(&d->ui_pool, &d->ui_content, d, 0, 0, cell * POOL_SIDE, cell * POOL_SIDE);
+    d->ui_pool.draw = pool_draw;
+    d->ui_pool.touch = pool_touch;
+    ui_store_init(&d->pool, &d->ui_pool);
+    for (int i = 0; i < POOL_SIDE; i++) {
+        ui_t* row = ui_store_allocate(&d->pool, &d->ui_pool, d, 0, i * cell, cell * POOL_SIDE, cell);
+        assertion(row != null, "out of memory");
+        for (int j = 0; row != null && j < POOL_SIDE; j++) {
+            bool* mark = &d->pool_marks[i * POOL_SIDE + j];
+            ui_t* u = ui_store_allocate(&d->pool, row, mark, j * cell, 0, cell, cell);
+            assertion(u != null, "out of memory");
+            if (u != null) {
+                u->draw = pool_cell_draw;
+                u->touch = pool_cell_touch;
+            }
+        }
+    }
 }
 
 static void on_quit(ui_t* u) {
@@ -221,28 +386,59 @@ static void on_exit(ui_t* u) {
 static void on_glyphs(ui_t* u) {
     app_t* a = u->a;
     demo_t* d = (demo_t*)a->that;
+    ui.invalidate(&d->ui_glyphs); // shown or hidden
     sys.show_keyboard(a, !d->ui_glyphs.hidden);
 }
 
 static void on_test(ui_t* b) {
-//  app_t* a = u->a;
-//  sys.invalidate(b->btn.ui.a); // no need to call invalidate here
+    demo_t* d = (demo_t*)b->a->that;
+    ui.invalidate(&d->ui_content); // test draws over the whole content
 }
 
-static void init_ui(demo_t* d) {
-    ui_t* content = &d->ui_content;
-    ui.init(content, &d->a.root, d, 0, 0, d->a.root.w, d->a.root.h);
+static void init_layout(demo_t* d) {
     float vgap = pt2px(&d->a, VERTICAL_GAP_PT);
     float hgap = pt2px(&d->a, HORIZONTAL_GAP_PT);
-    float bh = d->font.height * 3 / 2; // button height
-    float y = 240 + vgap;
-    init_button(d, &d->quit,     10, y, 0, 'q', "Q", "Quit",      on_quit);   y += bh + vgap;
-    init_button(d, &d->exit,     10, y, 0, 'e', "E", "Exit(153)", on_exit);   y += bh + vgap;
-    init_checkbox(d, &d->test,   10, y, 0, 'x', "X", "Test",      on_test);   y += bh + vgap;
-    init_checkbox(d, &d->glyphs, 10, y, 0, 'x', "X", "Glyphs",    on_glyphs); y += bh + vgap;
+    layout_t* content = &d->layout.content;
+    layout_t* columns = &d->layout.columns;
+    layout_t* left    = &d->layout.left;
+    layout_t* right   = &d->layout.right;
+    d->layout.count = 0;
+    layout_init(content, LAYOUT_COLUMN, &d->ui_content);
+    content->padding = hgap;
+    content->gap = vgap;
+    layout_leaf(d, content, &d->ui_textures);
+    layout_init(columns, LAYOUT_ROW, null);
+    columns->gap = hgap * 2;
+    layout_add(content, columns);
+    layout_init(left, LAYOUT_COLUMN, null);
+    left->gap = vgap;
+    layout_add(columns, left);
+    layout_leaf(d, left, &d->quit.btn.u);
+    layout_leaf(d, left, &d->exit.btn.u);
+    layout_leaf(d, left, &d->test.btn.u);
+    layout_leaf(d, left, &d->glyphs.btn.u);
+    layout_leaf(d, left, &d->ui_ascii);
+    layout_leaf(d, left, &d->ui_pool);
+    layout_init(right, LAYOUT_COLUMN, null);
+    right->gap = vgap;
+    layout_add(columns, right);
+    layout_leaf(d, right, &d->slider1.u);
+    layout_leaf(d, right, &d->slider2.u);
+    layout_leaf(d, right, &d->ui_glyphs); // hidden glyphs atlas keeps its space
+    layout_leaf(d, right, &d->edit.u);
+}
+
+static void init_ui(demo_t* d) { // positions are assigned by layout
+    ui_t* content = &d->ui_content;
+    ui.init(content, &d->a.root, d, 0, 0, d->a.root.w, d->a.root.h);
+    init_button(d, &d->quit,     0, 0, 0, 'q', "Q", "Quit",      on_quit);
+    init_button(d, &d->exit,     0, 0, 0, 'e', "E", "Exit(153)", on_exit);
+    init_checkbox(d, &d->test,   0, 0, 0, 'x', "X", "Test",      on_test);
+    init_checkbox(d, &d->glyphs, 0, 0, 0, 'x', "X", "Glyphs",    on_glyphs);
     // ascii and ui_textures views
-    ui.init(&d->ui_ascii, content, d, 0, y, d->font.em * 26, d->font.em * 4);
+    ui.init(&d->ui_ascii, content, d, 0, 0, d->font.em * 26, d->font.em * 4);
     d->ui_ascii.draw = ascii_draw;
+    init_pool(d);
     content->draw  = content_draw;
     content->touch = content_touch;
     content->keyboard = content_keyboard;
@@ -250,47 +446,88 @@ static void init_ui(demo_t* d) {
     d->ui_textures.touch = textures_touch;
     d->ui_textures.draw = textures_draw;
     // sliders
-    float x = d->glyphs.btn.u.w + hgap;
-    y = 240 + vgap;
     d->slider1_minimum = 0;
     d->slider1_maximum = 255;
     d->slider1_current = 240;
     snprintf0(d->slider1_label, SLIDER1_LABEL, d->slider1_current);
-    init_slider(d, &d->slider1, x, y, d->slider1_label, &d->slider1_minimum, &d->slider1_maximum, &d->slider1_current);
-    y += bh + vgap;
+    init_slider(d, &d->slider1, 0, 0, d->slider1_label, &d->slider1_minimum, &d->slider1_maximum, &d->slider1_current);
     d->slider2_minimum = 0;
     d->slider2_maximum = 1023;
     d->slider2_current = 512;
     snprintf0(d->slider2_label, SLIDER2_LABEL, d->slider2_current);
-    init_slider(d, &d->slider2, x, y, d->slider2_label, &d->slider2_minimum, &d->slider2_maximum, &d->slider2_current);
-    y += bh + vgap;
-    ui.init(&d->ui_glyphs, content, d, x, y, d->font.atlas.w, d->font.atlas.h);
+    init_slider(d, &d->slider2, 0, 0, d->slider2_label, &d->slider2_minimum, &d->slider2_maximum, &d->slider2_current);
+    ui.init(&d->ui_glyphs, content, d, 0, 0, d->sdf.atlas.w, d->sdf.atlas.h);
     d->ui_glyphs.draw = glyphs_draw;
     d->ui_glyphs.hidden = true;
     d->test.btn.flip = &d->testing;
     d->glyphs.btn.flip = &d->ui_glyphs.hidden;
     d->glyphs.btn.inverse = true; // because flip point to hidden not to `shown` in the absence of that bit
-    y += d->font.atlas.h;
     // editor:
     d->edit.text = "Hello World!\r\nGood bye cruel Universe\nLast Line...";
     d->edit.bytes = (int)strlen(d->edit.text);
-    // ui_ascii width is d->font.em * 26
-    edit_init(&d->edit, content, d, d->font.em * 26 + 2 * hgap, y, d->font.em * 30, d->font.height * 5);
+    edit_init(&d->edit, content, d, 0, 0, d->font.em * 30, d->font.height * 5);
+    init_layout(d);
+    d->font_height_px = d->font.height;
+}
+
+static void done_ui(demo_t* d) {
+    if (d->ui_content.a != null) {
+        button_done(&d->quit);
+        button_done(&d->exit);
+        checkbox_done(&d->test);
+        checkbox_done(&d->glyphs);
+        slider_done(&d->slider1);
+        slider_done(&d->slider2);
+        edit_done(&d->edit);
+        ui.done(&d->ui_textures);
+        ui.done(&d->ui_glyphs);
+        ui.done(&d->ui_ascii);
+        ui_store_dispose(&d->pool);
+        ui.done(&d->ui_pool);
+        ui.done(&d->ui_content);
+        d->font_height_px = 0;
+    }
 }
 
-static void load_font(demo_t* d) {
+static void load_atlas(demo_t* d) { // CPU: touches only d->sdf
     int r = 0;
-    int hpx = (int)(pt2px(&d->a, FONT_HEIGHT_PT) + 0.5); // font height in pixels
-    if (hpx != d->font.height) {
-        if (d->font.atlas.data != null) { font_dispose(&d->font); }
+    if (d->sdf.chars == null) {
         // https://en.wikipedia.org/wiki/Liberation_fonts https://github.com/liberationfonts
         // https://github.com/liberationfonts/liberation-fonts/releases
         // Useful: https://www.glyphrstudio.com/online/ and https://convertio.co/otf-ttf/
         // https://github.com/googlefonts/noto-fonts/tree/master
-        r = font_load_asset(&d->font, &d->a, "liberation-mono-bold-ascii.ttf", hpx, 32, 98);
+        // baked with: font_bake -sdf liberation-mono-bold-ascii.ttf 32 32 98 liberation-mono-bold-ascii.fnt
+        r = font_load_baked(&d->sdf, &d->a, "liberation-mono-bold-ascii.fnt");
+        if (r != 0) { // no baked asset: rasterize at startup
+            r = font_load_asset_sdf(&d->sdf, &d->a, "liberation-mono-bold-ascii.ttf", FONT_ATLAS_HEIGHT_PX, 32, 98);
+        }
+        assert(r == 0);
+        if (r != 0) { exit(r); } // fatal
+    }
+}
+
+static void scale_fonts(demo_t* d) { // UI thread: text_cache and face_font() are not thread safe
+    int r = 0;
+    // DPI changes do not re-rasterize glyphs, the same atlas is scaled
+    int hpx = (int)(pt2px(&d->a, FONT_HEIGHT_PT) + 0.5); // font height in pixels
+    if (d->font.height != hpx) {
+        r = font_scaled(&d->font, &d->sdf, hpx);
         assert(r == 0); (void)r;
     }
-    r = texture_allocate_and_update(&d->font.atlas);
+    if (d->mono == null || d->mono->height != hpx) { // font keeps its face chain open
+        face_t* ascii = face_open(&d->a, "liberation-mono-bold-ascii.ttf");
+        face_t* symbols = face_open(&d->a, "liberation-mono-bold-symbols.ttf");
+        if (ascii != null && symbols != null) { face_fallback(ascii, symbols); }
+        // faces are held open here: releasing the old size does not unmap them
+        if (d->mono != null) { face_font_release(d->mono); }
+        d->mono = ascii != null ? face_font(ascii, hpx) : null;
+        face_close(symbols);
+        face_close(ascii);
+    }
+}
+
+static void upload_font(demo_t* d) {
+    int r = font_allocate(&d->sdf);
     assert(r == 0);
     if (r != 0) { exit(r); } // fatal
 }
@@ -340,38 +577,91 @@ static int create_gl_program(app_t* a, const char* name, int *program) {
     return r;
 }
 
+static void arrange(demo_t* d) {
+    ui_t* root = &d->a.root;
+    if (d->ui_content.a != null) { layout_arrange(&d->layout.content, 0, 0, root->w, root->h); }
+}
+
 static void resized(app_t* a, int x, int y, int w, int h) {
     // both model and view matricies are identity:
     ui_t* root = &a->root;
-    root->x = x;
-    root->y = y;
-    root->w = w;
-    root->h = h;
+    ui.set_bounds(root, x, y, w, h);
     dc.viewport(&dc, root->x, root->y, root->w, root->h);
+    arrange((demo_t*)a->that); // only moved widgets, no need to rebuild ui
     // no need to call invalidate() caller will do it
 }
 
-static void shown(app_t* a, int w, int h) {
-    a->root.w = w;
-    a->root.h = h;
+static const char* bitmap_assets[] = {
+    "cube-320x240.png", "geometry-320x240.png", "machine-320x240.png"
+};
+
+// startup phases: CPU only phases do not touch GL and run on worker threads.
+// They also must not touch UI thread only state: text_cache, face_font(),
+// ui tree, spatial index, btn shortcuts and sys.invalidate() - phases that
+// do are marked `gl' and run on the UI thread like GL phases.
+
+static void phase_decode(task_t* t) { // CPU
+    texture_t* b = (texture_t*)t->that;
+    if (b->data == null) { texture_load_asset(b, app, t->name); }
+}
+
+static void phase_font(task_t* t) { load_atlas((demo_t*)t->that); } // CPU
+
+static void phase_layout(task_t* t) { // UI: needs font atlas
+    demo_t* d = (demo_t*)t->that;
+    scale_fonts(d);
+    init_theme(d);
+    // ui tree survives hidden() and is rebuilt only when font height (DPI) changed
+    if (d->font_height_px != d->font.height) {
+        done_ui(d);
+        init_ui(d);
+    }
+}
+
+static void phase_dc(task_t* t) { // GL
+    const rectf_t* v = (const rectf_t*)t->that; // root bounds set by shown() before tasks_run()
     dc.init(&dc);
-    resized(a, 0, 0, w, h);
+    dc.viewport(&dc, v->x, v->y, v->w, v->h);
+}
+
+static void phase_shaders(task_t* t) { // GL
+    int r = shaders_init();
+    assert(r == 0); (void)r;
+}
+
+static void phase_texture(task_t* t) { texture_allocate_and_update((texture_t*)t->that); } // GL
+
+static void phase_atlas(task_t* t) { upload_font((demo_t*)t->that); } // GL
+
+static void shown(app_t* a, int w, int h) {
+    ui.set_bounds(&a->root, a->root.x, a->root.y, w, h);
     demo_t* d = (demo_t*)a->that;
-    load_font(d);
     (void)create_gl_program;
 //  int r = create_gl_program(a, "main", &d->program_main);
-    int r = shaders_init();
-    assert(r == 0);
-    init_theme(d);
+    rectf_t viewport = { a->root.x, a->root.y, a->root.w, a->root.h };
+    task_t dc_init = { "dc.init",  phase_dc,      &viewport, true };
+    task_t shaders = { "shaders",  phase_shaders, d, true, { &dc_init } };
+    task_t font    = { "font",     phase_font,    d, false };
+    task_t atlas   = { "atlas",    phase_atlas,   d, true, { &font, &dc_init } };
+    task_t layout  = { "layout",   phase_layout,  d, true, { &font } };
+    task_t decode[countof(d->bitmaps)] = {};
+    task_t upload[countof(d->bitmaps)] = {};
+    task_t* tasks[5 + countof(decode) + countof(upload)] = { &dc_init, &shaders, &font, &atlas, &layout };
+    int n = 5;
     for (int i = 0; i < countof(d->bitmaps); i++) {
-        texture_allocate_and_update(&d->bitmaps[i]);
+        decode[i] = (task_t){ bitmap_assets[i], phase_decode, &d->bitmaps[i], false };
+        upload[i] = (task_t){ "texture", phase_texture, &d->bitmaps[i], true, { &decode[i], &dc_init } };
+        tasks[n++] = &decode[i];
+        tasks[n++] = &upload[i];
     }
-    init_ui(d);
+    tasks_run("startup", tasks, n);
+    arrange(d);
     toast_print(0, "resolution\n%.0fx%.0fpx", a->root.w, a->root.h);
 }
 
 static void draw(app_t* a) {
     assertion(!a->root.hidden, "there is no meaningful reason to hide root");
+    dc.frame(&dc);
     a->root.draw(&a->root);
 }
 
@@ -380,19 +670,10 @@ static void hidden(app_t* a) {
     // Application/activity is detached from the window.
     // Window surface may be different next time application is shown()
     // On Android application may continue running.
+    // Only GL resources are released, ui and layout trees are kept for shown().
     toast_cancel();
-    button_done(&d->quit);
-    button_done(&d->exit);
-    checkbox_done(&d->glyphs);
-    checkbox_done(&d->test);
-    slider_done(&d->slider1);
-    slider_done(&d->slider2);
-    edit_done(&d->edit);
-    ui.done(&d->ui_textures);
-    ui.done(&d->ui_glyphs);
-    ui.done(&d->ui_ascii);
-    ui.done(&d->ui_content);
-    texture_deallocate(&d->font.atlas);
+    font_deallocate(&d->sdf);
+    faces_deallocate();
     for (int i = 0; i < countof(d->bitmaps); i++) { texture_deallocate(&d->bitmaps[i]); }
 //  shader_program_dispose(d->program_main);   d->program_main = 0;
     shaders_dispose();
@@ -413,19 +694,18 @@ static void init(app_t* a) { // init application
     a->root.that = &d;
     app->root    = ui_proto;
     app->root.a  = a;
-    if (d->bitmaps[0].data == null) {
-        texture_load_asset(&d->bitmaps[0], a, "cube-320x240.png");
-        texture_load_asset(&d->bitmaps[1], a, "geometry-320x240.png");
-        texture_load_asset(&d->bitmaps[2], a, "machine-320x240.png");
-    }
+    // bitmaps are decoded by startup tasks in shown()
 }
 
 static void done(app_t* a) {
     demo_t* d = (demo_t*)a->that;
+    done_ui(d);
     for (int i = 0; i < countof(d->bitmaps); i++) {
         texture_dispose(&d->bitmaps[i]);
     }
     font_dispose(&d->font);
+    font_dispose(&d->sdf);
+    if (d->mono != null) { face_font_release(d->mono); d->mono = null; }
 }
 
 bool key(app_t* a, int flags, int keycode) {
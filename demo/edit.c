@@ -155,19 +155,20 @@ static void edit_draw(ui_t* u) {
     app_t*   a = u->a;
     theme_t* t = &a->theme;
     font_t*  f = t->font;
-    int y = u->y;
+    const rectf_t r = ui.screen_rect(u);
+    int y = r.y;
     int n = (u->w + f->em - 1) / f->em;
     char text[n + 1];
     int pos = e->screen;
     edit_chunk_t* c = locate(e, pos);
-    while (c != null && y < u->y + u->h) {
+    while (c != null && y < r.y + r.h) {
         int eol = pos;
         edit_chunk_t* next = next_eol(e, c, &eol);
         int m = min(n, next == null ? c->pos + c->count - pos : eol - pos);
         edit_read(e, text, pos, m); // TODO: can be optimized to start from chunk "c"
         if (m > 0 && text[m] == LF) { m--; } // do not draw LF
         if (m > 0 && text[m] == CR) { m--; } // do not draw CR
-        dc.text(&dc, t->color_text, f, u->x, y, text, m);
+        dc.text(&dc, t->color_text, f, r.x, y, text, m);
         y += f->height;
         pos = eol;
         c = next;
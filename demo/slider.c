@@ -18,7 +18,7 @@ static const char* SLIDER_INC_LABEL = "[+]";
 
 static void slider_notify(slider_t* s) {
     s->notify(s);
-    sys.invalidate(s->u.a); // after notify because notify may do something to layout etc...
+    ui.invalidate(&s->u); // after notify because notify may do something to layout etc...
 }
 
 static int slider_scale(slider_t* s) {
@@ -59,26 +59,22 @@ static bool slider_click_inc_dec(slider_t* s, int direction, int d) {
     return changed;
 }
 
-static void slider_autorepeat(timer_callback_t* tcb) {
-    slider_t* s = (slider_t*)tcb->that;
-    if ((s->u.a->touch_flags & MOUSE_LBUTTON_FLAG) == 0 && tcb->id > 0) {
-        sys.timer_remove(s->u.a, tcb);
-    } else {
+static void slider_autorepeat(animation_t* animation) {
+    // first repeat in 350 milliseconds then 30 times per second (on the frames they fall into)
+    static const uint64_t delay = 350ULL * NS_IN_MS;
+    slider_t* s = (slider_t*)animation->that;
+    if ((s->u.a->touch_flags & MOUSE_LBUTTON_FLAG) == 0) {
+        animation_stop(animation);
+    } else if (animation->elapsed >= delay) {
+        const int due = (int)((animation->elapsed - delay) * 30 / NS_IN_SEC) + 1;
         const int x = s->u.a->last_touch_x - s->u.x;
         const int y = s->u.a->last_touch_y - s->u.y;
-        if (slider_click_inc_dec(s, slider_dec_inc(s, x, y), slider_scale(s))) {
-            slider_notify(s);
+        bool changed = false;
+        while (s->repeats < due) {
+            changed |= slider_click_inc_dec(s, slider_dec_inc(s, x, y), slider_scale(s));
+            s->repeats++;
         }
-    }
-}
-
-static void slider_start_autorepeat(timer_callback_t* tcb) {
-    slider_t* s = (slider_t*)tcb->that;
-    sys.timer_remove(s->u.a, tcb);
-    if ((s->u.a->touch_flags & MOUSE_LBUTTON_FLAG) != 0) {
-        s->timer_callback.callback = slider_autorepeat;
-        s->timer_callback.ns = (1000ULL * NS_IN_MS) / 30; // 30 times per second
-        sys.timer_add(s->u.a, tcb);
+        if (changed) { slider_notify(s); }
     }
 }
 
@@ -88,17 +84,20 @@ static bool slider_touch(ui_t* u, int touch_action, float x, float y) {
     theme_t* theme = &u->a->theme;
     bool consumed = false;
     if (s->u.focusable && (touch_action & TOUCH_DOWN) != 0) {
+        ui.capture(u); // drag and up outside of the slider bounds
         bool changed = slider_click_inc_dec(s, slider_dec_inc(s, x, y), slider_scale(s));
         if (changed) {
-            if (s->timer_callback.id <= 0) {
-                s->timer_callback.that = s;
-                s->timer_callback.callback = slider_start_autorepeat;
-                s->timer_callback.ns = 350ULL * NS_IN_MS; // first timer fires in 350 milliseconds
-                sys.timer_add(a, &s->timer_callback);
+            if (!s->autorepeat.active) {
+                s->autorepeat.that = s;
+                s->autorepeat.step = slider_autorepeat;
+                s->repeats = 0;
+                animation_start(&s->autorepeat);
             }
             slider_notify(s);
             consumed = true;
         }
+    } else if (touch_action & TOUCH_UP) {
+        if (s->autorepeat.active) { animation_stop(&s->autorepeat); }
     } else if (s->u.focusable && (a->touch_flags & MOUSE_LBUTTON_FLAG)) { // drag with mouse button down
         const float em4 = theme->font->em / 4;
         const float dec_width = font_text_width(theme->font, SLIDER_DEC_LABEL, -1) + em4;
@@ -124,12 +123,9 @@ static bool slider_touch(ui_t* u, int touch_action, float x, float y) {
     return consumed;
 }
 
-static void slider_screen_touch(ui_t* u, int touch_action, float x, float y) {
+static void slider_enter(ui_t* u, bool inside) {
     slider_t* s = (slider_t*)u;
-    app_t* a = u->a;
-    if (((a->touch_flags & MOUSE_LBUTTON_FLAG) == 0 || (touch_action & TOUCH_UP) != 0) && s->timer_callback.id != 0) {
-        sys.timer_remove(u->a, &s->timer_callback);
-    }
+    if (!inside && s->autorepeat.active) { animation_stop(&s->autorepeat); }
 }
 
 static int slider_dec_inc_key(slider_t* s, int flags, int ch) {
@@ -174,7 +170,7 @@ static void slider_draw(ui_t* u) {
     app_t* a = u->a;
     theme_t* theme = &a->theme;
     assertion(*s->maximum - *s->minimum > 0, "range must be positive [%d..%d]", *s->minimum, *s->maximum);
-    const pointf_t pt = ui.screen_xy(u);
+    const rectf_t pt = ui.screen_rect(u);
     font_t* f = theme->font;
     const float fh = f->height;
     const float em4 = f->em / 4;
@@ -197,7 +193,7 @@ static void slider_draw(ui_t* u) {
         assertion(*s->minimum <= *s->current && *s->current <= *s->maximum, "s->current=%d out of range: [%d..%d]", *s->current, *s->minimum, *s->maximum);
         const double r = (*s->current - *s->minimum) / (double)(*s->maximum - *s->minimum);
         x = pt.x + dec_width;
-        y = u->y + baseline + 1.5;
+        y = pt.y + baseline + 1.5;
         const float w = (float)(indicator_width * r);
         const float h = u->h - baseline - 3;
         dc.fill(&dc, theme->color_slider, x, y, w, h);
@@ -230,11 +226,12 @@ void slider_init(slider_t* s, ui_t* parent, void* that,
     s->u.draw = slider_draw;
     s->u.touch = slider_touch;
     s->u.keyboard = slider_keyboard;
-    s->u.screen_touch = slider_screen_touch;
+    s->u.enter = slider_enter;
 }
 
 void slider_done(slider_t* s) {
     if (s != null) {
+        animation_stop(&s->autorepeat);
         ui.remove(s->u.parent, &s->u);
         memset(s, 0, sizeof(*s));
     }
@@ -10,6 +10,7 @@
    See the License for the specific language governing permissions and
    limitations under the License. */
 #include "ui.h"
+#include "animation.h"
 
 begin_c
 
@@ -23,8 +24,8 @@ typedef struct slider_s {
     int* current;
     const char*  label;           // can be null
     // internal state:
-    int timer_id;
-    timer_callback_t timer_callback;
+    animation_t autorepeat; // of [+]/[-] while pressed
+    int repeats;            // since press
 } slider_t;
 
 void slider_init(slider_t* s, ui_t* parent, void* that,
@@ -9,6 +9,7 @@
    See the License for the specific language governing permissions and
    limitations under the License. */
 #include "app.h"
+#include "animation.h"
 #include "droid_keys.h"
 #include "droid_jni.h" // interface to Java only code (going via binder is too involving)
 #include <EGL/egl.h>
@@ -22,6 +23,9 @@
 #include <android/log.h>
 #include <android/hardware_buffer.h>
 #include <android/hardware_buffer_jni.h>
+#include <stdatomic.h>
+#include <sys/timerfd.h>
+#include <dlfcn.h>
 
 // see:
 // https://github.com/aosp-mirror/platform_frameworks_base/blob/master/core/java/android/app/NativeActivity.java
@@ -48,14 +52,14 @@ enum {
     // android_poll_source structure.  These can be read via the input_queue object.
     LOOPER_ID_INPUT = 2,
     LOOPER_ID_ACCEL = 3,
+    LOOPER_ID_TIMER = 4,
     // Start of user-defined ALooper identifiers.
-    LOOPER_ID_USER  = 4,
+    LOOPER_ID_USER  = 5,
 };
 
 enum {
     COMMAND_REDRAW = 1,
-    COMMAND_TIMER  = 2,
-    COMMAND_QUIT   = 3
+    COMMAND_QUIT   = 2
 };
 
 typedef struct app_state_s {
@@ -78,16 +82,34 @@ typedef struct glue_s {
     const ASensor*  accelerometer_sensor;
     ASensorEventQueue* sensor_event_queue;
     int running; // == 1 between on_resume() and on_pause()
-    volatile int destroy_requested;
     uint64_t start_time_in_ns;
-    timer_callback_t* timers[32]; // maximum 32 timers allowed to avoid alloc and linked list
-    volatile uint64_t timer_next_ns; // time in ns till next COMMAND_TIMER
-    pthread_t timer_thread;
-    pthread_mutex_t mutex;
-    pthread_cond_t  cond;
+    struct {
+        timer_callback_t** heap; // min-heap by deadline
+        int count;
+        int capacity;
+        int ids;          // last issued timer id
+        int fd;           // timerfd polled by the looper
+        uint64_t armed;   // deadline timerfd is set to, 0 when disarmed
+    } timers;
+    bool frame_posted; // animation frame callback is pending
+    bool framing;      // inside of animation frame: invalidate() redraws at its end
+    bool frame_redraw;
+    atomic_bool redraw_pending; // COMMAND_REDRAW is in the pipe, invalidate() does not add another
+    struct {
+        uint64_t frames;    // drawn
+        uint64_t requests;  // invalidate() calls
+        uint64_t coalesced; // requests that did not produce a frame of their own
+    } stats;
+    struct { // AChoreographer is API 24+ and minSdk is 23: resolved at run time
+        void* (*get_instance)(void);
+        void  (*post)(void* c, void (*callback)(long frame_time_ns, void* data), void* data);
+        void  (*post64)(void* c, void (*callback)(int64_t frame_time_ns, void* data), void* data); // 29+
+    } choreographer;
+    timer_callback_t frame_timer; // 60Hz frames while animating when there is no AChoreographer
     EGLDisplay display;
     EGLSurface surface;
     EGLContext context;
+    bool preserved; // back buffer is preserved by eglSwapBuffers()
     // android specific:
     AConfiguration* config;
     float inches_wide; // best guess for screen physical size
@@ -107,22 +129,11 @@ typedef struct glue_s {
     android_poll_source_t command_poll_source;
     android_poll_source_t input_poll_source;
     android_poll_source_t accel_poll_source;
+    android_poll_source_t timer_poll_source;
     droid_display_metrics_t dm;
     app_state_t state; // TODO: this is stub for testing on_save_state() on_create() state passing
 } glue_t;
 
-#define synchronized_wait(mutex, cond, timespec, code)      \
-    pthread_mutex_lock(&(mutex));                           \
-    pthread_cond_timedwait(&(cond), &(mutex), &(timespec)); \
-    code;                                                   \
-    pthread_mutex_unlock(&(mutex))
-
-#define synchronized_signal(mutex, cond, code) \
-    pthread_mutex_lock(&(mutex));              \
-    code;                                      \
-    pthread_cond_signal(&(cond));              \
-    pthread_mutex_unlock(&(mutex))
-
 static int logln(int level, const char* tag, const char* location, const char* format, va_list vl) {
     char fmt[1024];
     const char* f = format;
@@ -145,6 +156,7 @@ static const char* id2str(int id) {
         case_return(LOOPER_ID_MAIN);
         case_return(LOOPER_ID_INPUT);
         case_return(LOOPER_ID_ACCEL);
+        case_return(LOOPER_ID_TIMER);
         case_return(LOOPER_ID_USER);
         default: assertion(false, "id=%d", id); return "???";
     }
@@ -153,7 +165,6 @@ static const char* id2str(int id) {
 static const char* cmd2str(int command) {
     switch (command) {
         case_return(COMMAND_REDRAW);
-        case_return(COMMAND_TIMER);
         case_return(COMMAND_QUIT);
         default: assertion(false, "command=%d", command); return "???";
     }
@@ -184,7 +195,7 @@ static int8_t dequeue_command(glue_t* glue) {
 static void* asset_map(app_t* a, const char* name, const void* *data, int *bytes) {
     glue_t* glue = (glue_t*)a->glue;
     AAsset* asset = AAssetManager_open(glue->na->assetManager, name, AASSET_MODE_BUFFER);
-    assertion(asset != null, "asset not found \"%s\"", name);
+    if (asset == null) { traceln("asset not found \"%s\"", name); } // callers may probe optional assets
     *data = null;
     *bytes = 0;
     if (asset != null) {
@@ -207,8 +218,9 @@ static void process_configuration(glue_t* glue) {
 }
 
 static int init_display(glue_t* glue) {
-    const EGLint attribs[] = {
-        EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+    // preserved back buffer lets frames redraw only invalidated part of the window
+    EGLint attribs[] = {
+        EGL_SURFACE_TYPE, EGL_WINDOW_BIT|EGL_SWAP_BEHAVIOR_PRESERVED_BIT,
         EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
         EGL_BLUE_SIZE,  8,
         EGL_GREEN_SIZE, 8,
@@ -222,6 +234,10 @@ static int init_display(glue_t* glue) {
     EGLint configs_count = 0;
     EGLConfig config = 0;
     eglChooseConfig(display, attribs, &config, 1, &configs_count);
+    if (configs_count == 0) {
+        attribs[1] = EGL_WINDOW_BIT;
+        eglChooseConfig(display, attribs, &config, 1, &configs_count);
+    }
     EGLint id = 0;
     eglGetConfigAttrib(display, config, EGL_NATIVE_VISUAL_ID,   &id);
     eglGetConfigAttrib(display, config, EGL_MAX_PBUFFER_WIDTH,  &glue->max_tex_w);
@@ -229,6 +245,8 @@ static int init_display(glue_t* glue) {
     uint32_t format = AHARDWAREBUFFER_FORMAT_R8G8B8A8_UNORM;
     ANativeWindow_setBuffersGeometry(glue->window, 0, 0, format);
     EGLSurface surface = eglCreateWindowSurface(display, config, glue->window, null);
+    glue->preserved = (attribs[1] & EGL_SWAP_BEHAVIOR_PRESERVED_BIT) != 0 &&
+        eglSurfaceAttrib(display, surface, EGL_SWAP_BEHAVIOR, EGL_BUFFER_PRESERVED);
     EGLContext context = EGL_NO_CONTEXT;
     for (int gles = 3; gles >= 2; gles--) {
         EGLint context_attributes[] = { EGL_CONTEXT_CLIENT_VERSION, gles, EGL_NONE };
@@ -256,19 +274,30 @@ static void focus(app_t* app, ui_t* u) {
     if (u == app->focused) {
         // already focused
     } else if (u == null || u->focusable) {
-        if (app->focused != null && app->focused->focus != null) {
-            app->focused->focus(app->focused, false);
+        if (app->focused != null) {
+            if (app->focused->focus != null) { app->focused->focus(app->focused, false); }
+            ui.invalidate(app->focused); // focus is drawn
         }
         app->focused = u;
-        if (u != null && u->focus != null) {
-            u->focus(u, true);
+        if (u != null) {
+            if (u->focus != null) { u->focus(u, true); }
+            ui.invalidate(u);
         }
     }
 }
 
 static void draw_frame(glue_t* glue) {
+    atomic_store(&glue->redraw_pending, false); // this frame satisfies all requests so far
+    glue->frame_redraw = false;
     if (glue->display != null) {
-        ((app_t*)glue->a)->draw((app_t*)glue->a);
+        glue->stats.frames++;
+        app_t* a = (app_t*)glue->a;
+        rectf_t r = a->invalid;
+        a->invalid = (rectf_t){}; // invalidated while drawing goes to the next frame
+        if (!glue->preserved || r.w <= 0 || r.h <= 0) { r = ui.screen_rect(&a->root); }
+        dc.clip(&dc, r.x, r.y, r.w, r.h);
+        a->draw(a);
+        dc.clip(&dc, 0, 0, 0, 0);
         // eglSwapBuffers performs an implicit flush operation on the context (glFlush for an OpenGL ES)
         bool swapped = eglSwapBuffers(glue->display, glue->surface);
         assertion(swapped, "eglSwapBuffers() failed"); (void)swapped;
@@ -304,11 +333,16 @@ static int32_t handle_motion(glue_t* glue, AInputEvent* me) {
     switch (act) {
         case AMOTION_EVENT_ACTION_DOWN        : action = TOUCH_DOWN; flags |=  MOUSE_LBUTTON_FLAG; break;
         case AMOTION_EVENT_ACTION_UP          : action = TOUCH_UP;   flags &= ~MOUSE_LBUTTON_FLAG; break;
+        case AMOTION_EVENT_ACTION_MOVE        : action = TOUCH_MOVE; break; // finger drag
         case AMOTION_EVENT_ACTION_HOVER_MOVE  : action = TOUCH_MOVE; break;
         case AMOTION_EVENT_ACTION_POINTER_DOWN: break; // touch event, "index" is "finger index"
         case AMOTION_EVENT_ACTION_POINTER_UP  : break;
         // mouse wheel and deodorant ball generates scrolls:
-        case AMOTION_EVENT_ACTION_SCROLL      : traceln("TODO: AMOTION_EVENT_ACTION_SCROLL"); break;
+        case AMOTION_EVENT_ACTION_SCROLL      :
+            action = MOUSE_WHEEL;
+            a->wheel_x = AMotionEvent_getAxisValue(me, AMOTION_EVENT_AXIS_HSCROLL, 0);
+            a->wheel_y = AMotionEvent_getAxisValue(me, AMOTION_EVENT_AXIS_VSCROLL, 0);
+            break;
         default: break;
     }
     if (index == 0) {
@@ -361,6 +395,9 @@ static int32_t handle_input(glue_t* glue, AInputEvent* ie) {
     }
 }
 
+static void animate(app_t* app);
+static void timers_arm(glue_t* glue);
+
 static void on_start(ANativeActivity* na) {
 }
 
@@ -375,6 +412,10 @@ static void on_pause(ANativeActivity* na) {
         ASensorEventQueue_disableSensor(glue->sensor_event_queue, glue->accelerometer_sensor);
     }
     if (glue->a->pause != null) { glue->a->pause(glue->a); }
+    timers_arm(glue); // disarmed while paused
+    traceln("frames: %llu redraw requests: %llu coalesced: %llu",
+            (unsigned long long)glue->stats.frames, (unsigned long long)glue->stats.requests,
+            (unsigned long long)glue->stats.coalesced);
 }
 
 static void on_resume(ANativeActivity* na) {
@@ -389,7 +430,8 @@ static void on_resume(ANativeActivity* na) {
     glue->a->resume(glue->a); // it is up to application code to resume animation if necessary
     // Leo - added draw frame on ANDROID_NA_COMMAND_GAINED_FOCUS and ANDROID_NA_COMMAND_RESUME
     draw_frame(glue);
-    enqueue_command(glue, COMMAND_TIMER); // timers were stopped on pause, wake them up
+    timers_arm(glue); // timers were stopped on pause, overdue ones fire right away
+    animate(glue->a); // animations were frozen on pause
 }
 
 // It is unclear *when* Android Activity Manager actually calls on_save_state().
@@ -417,7 +459,7 @@ static void on_native_window_created(ANativeActivity* na, ANativeWindow* window)
     init_display(glue);
     assertion(a->shown != null, "shown() cannot be null");
     a->shown(a, ANativeWindow_getWidth(window), ANativeWindow_getHeight(window));
-    sys.invalidate(a);
+    ui.invalidate(&a->root);
 }
 
 static void on_native_window_destroyed(ANativeActivity* na, ANativeWindow* window) {
@@ -445,13 +487,13 @@ static void on_low_memory(ANativeActivity* na) {
 static void on_native_window_resized(ANativeActivity* na, ANativeWindow* window) {
     glue_t* glue = (glue_t*)na->instance;
     assert(glue->window == window);
-    sys.invalidate(glue->a); // enqueue redraw command
+    ui.invalidate(&glue->a->root); // enqueue redraw command
 }
 
 static void on_native_window_redraw_needed(ANativeActivity* na, ANativeWindow* window) {
     glue_t* glue = (glue_t*)na->instance;
     assert(glue->window == window);
-    sys.invalidate(glue->a); // enqueue redraw command
+    ui.invalidate(&glue->a->root); // enqueue redraw command
 }
 
 static int looper_callback(int fd, int events, void* data) {
@@ -484,12 +526,21 @@ static void on_content_rect_changed(ANativeActivity* na, const ARect* rc) {
     app_t* a = glue->a;
     assertion(a->resized != null, "resized() cannot be null");
     a->resized(a, rc->left, rc->top, rc->right - rc->left, rc->bottom - rc->top);
-    sys.invalidate(a);
+    ui.invalidate(&a->root);
 }
 
 static void invalidate(app_t* app) {
     glue_t* glue = (glue_t*)app->glue;
-    enqueue_command(glue, COMMAND_REDRAW);
+    glue->stats.requests++;
+    if (glue->framing || glue->frame_posted) {
+        // once per vsync: by the animation frame in progress or already requested
+        if (glue->frame_redraw) { glue->stats.coalesced++; }
+        glue->frame_redraw = true;
+    } else if (atomic_exchange(&glue->redraw_pending, true)) {
+        glue->stats.coalesced++; // one frame per loop wake up
+    } else {
+        enqueue_command(glue, COMMAND_REDRAW);
+    }
 }
 
 static void quit(app_t* app) {
@@ -504,57 +555,72 @@ static void exit_(app_t* app, int code) {
     enqueue_command(glue, COMMAND_QUIT);
 }
 
-static const uint64_t FOREVER = 86400UL * NS_IN_SEC; // 24 hours
-
 static struct timespec ns_to_timespec(uint64_t ns) {
-    struct timespec ts = { (int)(ns / NS_IN_SEC), (long)(ns % NS_IN_SEC)};
+    struct timespec ts = { (time_t)(ns / NS_IN_SEC), (long)(ns % NS_IN_SEC)};
     return ts;
 }
 
-static void* timer_thread(void* p) {
-    glue_t* glue = (glue_t*)p;
-    uint64_t wait_ns = FOREVER; // 'forever' or until next wakeup
-    struct timespec ts = ns_to_timespec(time_monotonic_ns() + wait_ns);
-    while (!glue->destroy_requested) {
-        synchronized_wait(glue->mutex, glue->cond, ts,
-            wait_ns = glue->timer_next_ns;
-            ts = ns_to_timespec(time_monotonic_ns() + wait_ns);
-        );
-        if (!glue->destroy_requested) {
-            enqueue_command(glue, COMMAND_TIMER);
-        }
+/* Timers are kept in a binary min-heap by deadline. timerfd is armed to the
+   nearest deadline and polled by the looper of the main thread, thus there is
+   one wake up per deadline and no timer thread. */
+
+static void timers_place(glue_t* glue, int i, timer_callback_t* tc) {
+    glue->timers.heap[i] = tc;
+    tc->position = i;
+}
+
+static void timers_sift_up(glue_t* glue, int i) {
+    timer_callback_t* tc = glue->timers.heap[i];
+    while (i > 0 && tc->deadline < glue->timers.heap[(i - 1) / 2]->deadline) {
+        timers_place(glue, i, glue->timers.heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    timers_place(glue, i, tc);
+}
+
+static void timers_sift_down(glue_t* glue, int i) {
+    timer_callback_t** heap = glue->timers.heap;
+    const int n = glue->timers.count;
+    timer_callback_t* tc = heap[i];
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= n) { break; }
+        if (c + 1 < n && heap[c + 1]->deadline < heap[c]->deadline) { c++; }
+        if (tc->deadline <= heap[c]->deadline) { break; }
+        timers_place(glue, i, heap[c]);
+        i = c;
     }
-    return null;
-}
-
-static void on_timer(glue_t* glue) {
-    int64_t earliest = -1;
-    for (int i = 1; i < countof(glue->timers); i++) {
-        timer_callback_t* tc = glue->timers[i];
-        if (tc != null) {
-            const uint64_t now = time_monotonic_ns();
-            if (tc->last_fired == 0) {
-                // first time event is seen not actually calling timer callback here
-                tc->last_fired = now;
-            } else {
-                assert(tc->ns > 0);
-                uint64_t next = tc->last_fired + tc->ns;
-                if (now >= next) {
-                    tc->callback(tc);
-                    // timer might have been removed and deallocated
-                    // inside callback call (not a good practice)
-                    if (tc == glue->timers[i]) { tc->last_fired = now; }
-                }
-            }
-            if (earliest < 0 || tc->ns < earliest) {
-                earliest = tc->ns;
-            }
+    timers_place(glue, i, tc);
+}
+
+static void timers_arm(glue_t* glue) { // to the nearest deadline, disarmed while paused
+    const uint64_t deadline = glue->running && glue->timers.count > 0 ? glue->timers.heap[0]->deadline : 0;
+    if (deadline != glue->timers.armed) {
+        const struct itimerspec its = { .it_value = ns_to_timespec(deadline) }; // zero disarms
+        if (timerfd_settime(glue->timers.fd, TFD_TIMER_ABSTIME, &its, null) != 0) {
+            traceln("timerfd_settime() failed: %s", strerror(errno));
         }
+        glue->timers.armed = deadline;
+    }
+}
+
+static void on_timer(glue_t* glue, android_poll_source_t* source) {
+    uint64_t expirations = 0;
+    if (read(glue->timers.fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+        traceln("timerfd read() failed: %s", strerror(errno));
     }
-    if (earliest < 0 || !glue->running) { earliest = FOREVER; } // wait `forever' or until next wakeup
-    if (earliest != glue->timer_next_ns) {
-        synchronized_signal(glue->mutex, glue->cond, glue->timer_next_ns = earliest);
+    glue->timers.armed = 0; // expired
+    const uint64_t now = time_monotonic_ns();
+    while (glue->running && glue->timers.count > 0 && glue->timers.heap[0]->deadline <= now) {
+        timer_callback_t* tc = glue->timers.heap[0];
+        tc->last_fired = now;
+        tc->deadline += tc->ns;
+        if (tc->deadline <= now) { tc->deadline = now + tc->ns; } // missed periods are skipped
+        timers_sift_down(glue, 0);
+        glue->a->time_in_nanoseconds = now - glue->start_time_in_ns; // animations step by it
+        tc->callback(tc); // may add and remove timers including itself
     }
+    timers_arm(glue);
 }
 
 static int timer_add(app_t* app, timer_callback_t* tcb) {
@@ -562,40 +628,107 @@ static int timer_add(app_t* app, timer_callback_t* tcb) {
     assertion(tcb->last_fired == 0, "last_fired=%lld != 0", tcb->last_fired);
     assertion(tcb->ns > 0, "ns=%d must be > 0", tcb->ns);
     if (tcb->ns == 0) { return -1; }
+    if (glue->timers.count == glue->timers.capacity) {
+        const int n = glue->timers.capacity == 0 ? 16 : glue->timers.capacity * 2;
+        timer_callback_t** heap = (timer_callback_t**)reallocate(glue->timers.heap, n * sizeof(timer_callback_t*));
+        assertion(heap != null, "out of memory");
+        if (heap == null) { return 0; }
+        glue->timers.heap = heap;
+        glue->timers.capacity = n;
+    }
     tcb->last_fired = 0;
-    int id = 0;
+    tcb->deadline = time_monotonic_ns() + tcb->ns;
     // IMPORTANT: id == 0 intentionally not used to allow timer_id = 0 initialization
-    for (int i = 1; i < countof(glue->timers); i++) {
-        if (glue->timers[i] == null) {
-            id = i;
-            break;
+    glue->timers.ids = glue->timers.ids == INT32_MAX ? 1 : glue->timers.ids + 1;
+    tcb->id = glue->timers.ids;
+    glue->timers.heap[glue->timers.count] = tcb;
+    glue->timers.count++;
+    timers_sift_up(glue, glue->timers.count - 1);
+    timers_arm(glue);
+    return tcb->id;
+}
+
+static void timer_remove(app_t* app, timer_callback_t* tcb) {
+    glue_t* glue = (glue_t*)app->glue;
+    const int i = tcb->position;
+    assertion(tcb->id != 0, "timer is not set");
+    assertion(0 <= i && i < glue->timers.count && glue->timers.heap[i] == tcb,
+              "timer id=%d is not in the heap at %d", tcb->id, i);
+    if (tcb->id != 0 && 0 <= i && i < glue->timers.count && glue->timers.heap[i] == tcb) {
+        glue->timers.count--;
+        if (i < glue->timers.count) { // last timer takes the vacated place
+            timers_place(glue, i, glue->timers.heap[glue->timers.count]);
+            timers_sift_down(glue, i);
+            timers_sift_up(glue, i);
         }
+        tcb->id = 0;
+        tcb->last_fired = 0; // indicates that timer is not set see set_timer above
+        timers_arm(glue);
     }
-    if (id > 0) {
-        glue->timers[id] = tcb;
-        enqueue_command(glue, COMMAND_TIMER); // will recalculate 'earliest' -> 'timer_next_ns'
-    } else {
-        assertion(false, "too many timers");
+}
+
+static void on_frame(glue_t* glue, uint64_t frame_time_ns) {
+    app_t* a = glue->a;
+    glue->frame_posted = false;
+    bool more = false;
+    if (glue->running) { // paused: frames stop, on_resume() requests them again
+        a->time_in_nanoseconds = frame_time_ns - glue->start_time_in_ns;
+        glue->framing = true;
+        more = animation_frame(a);
+        glue->framing = false;
+        if (glue->frame_redraw) { draw_frame(glue); }
+    }
+    if (more) {
+        animate(a);
+    } else if (glue->frame_timer.id != 0) {
+        timer_remove(a, &glue->frame_timer);
     }
-    tcb->id = id;
-    return id;
 }
 
-static void timer_remove(app_t* app, timer_callback_t* tcb) {
+static void frame_callback64(int64_t frame_time_ns, void* data) { // CLOCK_MONOTONIC of vsync
+    on_frame((glue_t*)data, frame_time_ns);
+}
+
+static void frame_callback(long frame_time_ns, void* data) { // CLOCK_MONOTONIC of vsync
+    // long is 32 bit on armeabi-v7a and frame time is truncated there
+    on_frame((glue_t*)data, sizeof(long) >= sizeof(uint64_t) ? (uint64_t)frame_time_ns : time_monotonic_ns());
+}
+
+static void frame_timer_callback(timer_callback_t* tcb) {
+    // stays added while animating: deadlines advance by whole periods, no drift
+    on_frame((glue_t*)tcb->that, time_monotonic_ns());
+}
+
+static void animate(app_t* app) {
     glue_t* glue = (glue_t*)app->glue;
-    int id = tcb->id;
-    assertion(0 <= id && id < countof(glue->timers), "id=%d out of range [0..%d]", id, countof(glue->timers));
-    if (0 < id && id < countof(glue->timers)) {
-        assertion(glue->timers[id] != null, "app->timers[%d] already null", id);
-        if (glue->timers[id] != null) {
-            glue->timers[id] = null;
-            tcb->id = 0;
-            tcb->last_fired = 0; // indicates that timer is not set see set_timer above
+    if (!glue->frame_posted) {
+        glue->frame_posted = true;
+        void* c = glue->choreographer.get_instance != null ? glue->choreographer.get_instance() : null;
+        if (c != null && glue->choreographer.post64 != null) {
+            glue->choreographer.post64(c, frame_callback64, glue);
+        } else if (c != null && glue->choreographer.post != null) {
+            glue->choreographer.post(c, frame_callback, glue);
+        } else if (glue->frame_timer.id == 0) {
+            glue->frame_timer.that = glue;
+            glue->frame_timer.callback = frame_timer_callback;
+            glue->frame_timer.ns = NS_IN_SEC / 60;
+            timer_add(app, &glue->frame_timer);
         }
-        enqueue_command(glue, COMMAND_TIMER); // will recalculate 'earliest' -> 'timer_next_ns'
     }
 }
 
+static void init_choreographer(glue_t* glue) {
+    void* lib = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL); // stays loaded by the process
+    if (lib != null) {
+        glue->choreographer.get_instance = (void* (*)(void))dlsym(lib, "AChoreographer_getInstance");
+        glue->choreographer.post = (void (*)(void*, void (*)(long, void*), void*))
+            dlsym(lib, "AChoreographer_postFrameCallback");
+        glue->choreographer.post64 = (void (*)(void*, void (*)(int64_t, void*), void*))
+            dlsym(lib, "AChoreographer_postFrameCallback64");
+    }
+    if (glue->choreographer.get_instance == null) { traceln("no AChoreographer: frames are timed"); }
+}
+
 static int vibration_effect_to_milliseconds(int effect) {
     switch (effect) {
         case DEFAULT_AMPLITUDE  : return 60;
@@ -634,6 +767,11 @@ static void show_keyboard(app_t* app, bool on) {
     }
 }
 
+static const char* data_folder(app_t* app) {
+    glue_t* glue = (glue_t*)app->glue;
+    return glue->na != null ? glue->na->internalDataPath : null;
+}
+
 static void process_input(glue_t* glue, android_poll_source_t* source) {
     AInputEvent* ie = null;
     while (AInputQueue_getEvent(glue->input_queue, &ie) >= 0) {
@@ -648,8 +786,9 @@ static void process_input(glue_t* glue, android_poll_source_t* source) {
 static void process_command(glue_t* glue, android_poll_source_t* source) {
     int8_t command = dequeue_command(glue);
     switch (command) {
-        case COMMAND_REDRAW: draw_frame(glue); break;
-        case COMMAND_TIMER : on_timer(glue);   break;
+        case COMMAND_REDRAW: // animation frame may have drawn it already
+            if (atomic_load(&glue->redraw_pending)) { draw_frame(glue); }
+            break;
         case COMMAND_QUIT  :
             ANativeActivity_finish(glue->na);
             exit(glue->exit_code);
@@ -670,13 +809,12 @@ static void on_destroy(ANativeActivity* na) {
         ASensorManager_destroyEventQueue(glue->sensor_manager, glue->sensor_event_queue);
         glue->sensor_event_queue = null;
     }
-    glue->destroy_requested = true;
-    if (glue->timer_thread != 0) {
-        synchronized_signal(glue->mutex, glue->cond, glue->timer_next_ns = 0); // wake up timer_thread
-        pthread_join(glue->timer_thread, null); glue->timer_thread = 0;
-    }
-    pthread_mutex_destroy(&glue->mutex);
-    pthread_cond_destroy(&glue->cond);
+    ALooper_removeFd(glue->looper, glue->timers.fd);
+    close(glue->timers.fd); glue->timers.fd = 0;
+    deallocate(glue->timers.heap); glue->timers.heap = null;
+    glue->timers.count = 0;
+    glue->timers.capacity = 0;
+    glue->timers.armed = 0;
     close(glue->read_pipe);  glue->read_pipe = 0;
     close(glue->write_pipe); glue->write_pipe = 0;
     AConfiguration_delete(glue->config); glue->config = 0;
@@ -718,19 +856,21 @@ static void set_window_flags(ANativeActivity* na) {
     ANativeActivity_setWindowFlags(na, add, remove);
 }
 
-static void init_timer_thread(glue_t* glue) {
-    pthread_condattr_t cond_attr;
-    pthread_condattr_init(&cond_attr);
-    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
-    pthread_cond_init(&glue->cond, &cond_attr);
-    pthread_mutex_init(&glue->mutex, null);
-    assert(glue->timer_thread == 0);
-    pthread_attr_t attr;
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE); // PTHREAD_CREATE_DETACHED
-    int r = pthread_create(&glue->timer_thread, &attr, timer_thread, glue);
-    assert(r == 0);
-    pthread_attr_destroy(&attr);
+static void init_timers(glue_t* glue, ANativeActivity* na) {
+    glue->timers.fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (glue->timers.fd < 0) {
+        traceln("timerfd_create() failed: %s", strerror(errno));
+        ANativeActivity_finish(na);
+        abort();
+    } else {
+        glue->timer_poll_source.id = LOOPER_ID_TIMER;
+        glue->timer_poll_source.glue = glue;
+        glue->timer_poll_source.process = on_timer;
+        int r = ALooper_addFd(glue->looper, glue->timers.fd, LOOPER_ID_TIMER,
+            ALOOPER_EVENT_INPUT, looper_callback, &glue->timer_poll_source);
+        assert(r == 1);
+        if (r != 1) { traceln("ALooper_addFd() failed"); }
+    }
 }
 
 static void init_looper(glue_t* glue, ANativeActivity* na) {
@@ -817,7 +957,6 @@ static void create_activitiy(glue_t* glue, ANativeActivity* na, void* data, size
     assert(app->glue == glue);
     assert(app->focused == null);
     na->instance = glue;
-    glue->destroy_requested = false;
     glue->na = na;
     glue->start_time_in_ns = time_monotonic_ns();
     droid_jni_hide_navigation_bar(na);
@@ -829,8 +968,9 @@ static void create_activitiy(glue_t* glue, ANativeActivity* na, void* data, size
     init_callbacks(na->callbacks);
     set_window_flags(na);
     init_looper(glue, na);
+    init_choreographer(glue);
     init_accelerometer(glue);
-    init_timer_thread(glue);
+    init_timers(glue, na);
     assertion(app->init != null, "init() cannot be null");
     app->init(app);
 }
@@ -847,10 +987,12 @@ const sys_t sys = {
     focus,
     timer_add,
     timer_remove,
+    animate,
     asset_map,
     asset_unmap,
     vibrate,
     show_keyboard,
+    data_folder,
     logln
 };
 
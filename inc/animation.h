@@ -0,0 +1,66 @@
+#pragma once
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "ui.h"
+
+begin_c
+
+/* Frame synchronized animations. Platform glue calls animation_frame() once
+   per display frame (vsync) only while animations are active and draws the
+   invalidated ui right after it, thus nothing ticks when nothing moves.
+   All active animations see the same frame time app.time_in_nanoseconds.
+   Animation clock starts on the first frame after animation_start().
+   Tween: *value goes from `from` to `to` over `duration` shaped by easing,
+   repeated `repeat` more times (ANIMATION_FOREVER endless), odd cycles
+   backwards when `reverse` is set. duration == 0 makes endless animation
+   that only calls step() every frame (e.g. physics or autorepeat).
+   Animations may be started and stopped from step() and done(), stopped
+   animation stays linked till the end of the frame: do not zero or free
+   it from inside of a frame. */
+
+enum { ANIMATION_FOREVER = -1 };
+
+typedef struct animation_s animation_t;
+
+typedef struct animation_s {
+    float* value;         // tweened property or null
+    float from;
+    float to;
+    uint64_t duration;    // ns of a cycle, 0 for step() only animation
+    int repeat;           // cycles after the first one or ANIMATION_FOREVER
+    bool reverse;         // odd cycles run from `to` to `from`
+    float (*easing)(float t); // maps [0..1] time to [0..1] progress, null is linear
+    void (*step)(animation_t* a); // each frame after value is set, may be null
+    void (*done)(animation_t* a); // after the last frame of the last cycle, may be null
+    ui_t* u;              // invalidated each frame, may be null
+    void* that;
+    uint64_t elapsed;     // ns since the first frame
+    bool active;          // from animation_start() to animation_stop() or done()
+    // implementation:
+    bool started;         // first frame was seen
+    uint64_t start;       // app time of the first frame
+    bool linked;          // in the list of animations
+    animation_t* next;
+} animation_t;
+
+void animation_start(animation_t* a); // (re)starts from the beginning on the next frame
+
+void animation_stop(animation_t* a); // done() is not called, *value keeps last frame value
+
+// called by platform glue on display frame, returns true if next frame is needed
+bool animation_frame(app_t* a);
+
+float animation_linear(float t);
+float animation_ease_in(float t);     // cubic
+float animation_ease_out(float t);
+float animation_ease_in_out(float t);
+
+end_c
@@ -50,7 +50,10 @@ typedef struct app_s {
     int touch_flags;    // last mouse buttons flags (for finger index == 0)
     int last_touch_x;   // last touch/mouse screen coordinates
     int last_touch_y;
+    float wheel_x;      // of the last MOUSE_WHEEL: -1..+1 per detent, positive is right and up
+    float wheel_y;
     uint64_t time_in_nanoseconds; // since application start update on each event or animation
+    rectf_t invalid; // union of ui.invalidate() screen bounds to redraw, empty for whole screen
     theme_t theme;
 } app_t;
 
@@ -61,14 +64,16 @@ typedef struct sys_s {
     void  (*exit)(app_t* app, int code); // trying to exit application gracefully with specified return code
     bool  (*dispatch_key)(app_t* a, int flags, int keycode);
     bool  (*dispatch_touch)(app_t* a, int index, int action, int x, int y);
-    void  (*invalidate)(app_t* app);     // make application redraw once
+    void  (*invalidate)(app_t* app);     // make application redraw app.invalid (whole app when empty) once
     void  (*focus)(app_t* app, ui_t* u); // set application keyboard focus on particular ui element or null
-    int   (*timer_add)(app_t* a, timer_callback_t* tcb); // returns timer id > 0 or 0 if fails (too many timers)
+    int   (*timer_add)(app_t* a, timer_callback_t* tcb); // returns timer id > 0 or 0 if fails (out of memory)
     void  (*timer_remove)(app_t* a, timer_callback_t* tcb);
+    void  (*animate)(app_t* a); // calls animation_frame() on display frames while it returns true
     void* (*asset_map)(app_t* a, const char* name, const void* *data, int *bytes);
     void  (*asset_unmap)(app_t* a, void* asset, const void* data, int bytes);
     void  (*vibrate)(app_t* a, int vibration_effect);
     void  (*show_keyboard)(app_t* a, bool on); // shows/hides soft keyboard
+    const char* (*data_folder)(app_t* a); // writable private application folder or null
     int   (*logln)(int level, const char* tag, const char* location, const char* format, va_list vl); // may be null
 } sys_t;
 
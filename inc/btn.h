@@ -33,6 +33,8 @@ typedef struct btn_s {
     int bitset;    /* button state */
     bool* flip;    /* checkbox button *flip = !*flip; on each click */
     bool inverse;  /* inverse *flip value drawing UI */
+    // implementation:
+    btn_t* next_shortcut; /* in shortcuts hash bucket, key_flags and key must not change after btn_init() */
 } btn_t;
 
 void btn_init(btn_t* b, ui_t* parent, void* that, int key_flags, int key,
@@ -41,4 +43,9 @@ void btn_init(btn_t* b, ui_t* parent, void* that, int key_flags, int key,
 
 void btn_done(btn_t* b);
 
+/* returns button with the keyboard shortcut that is not hidden itself and has
+   no hidden ancestors up to app root, or null. When several buttons share the
+   shortcut the first one in tree order (pre-order walk from app root) wins. */
+btn_t* btn_shortcut(int key_flags, int key);
+
 end_c
@@ -25,6 +25,8 @@ typedef struct dc_s { // draw commands/context
     void (*init)(dc_t* dc);
     void (*viewport)(dc_t* dc, float x, float y, float w, float h);
     void (*dispose)(dc_t* dc);
+    void (*frame)(dc_t* dc); // once per frame before drawing, ages caches
+    void (*clip)(dc_t* dc, float x, float y, float w, float h); // scissor, w or h <= 0 turns clipping off
     void (*clear)(dc_t* dc, const colorf_t* color);
     void (*fill)(dc_t* dc, const colorf_t* color, float x, float y, float w, float h);
     void (*rect)(dc_t* dc, const colorf_t* color, float x, float y, float w, float h, float thickness);
@@ -38,6 +40,7 @@ typedef struct dc_s { // draw commands/context
     void (*quadrant)(dc_t* dc, const colorf_t* color, float x, float y, float r, int quadrant);
     void (*stadium)(dc_t* dc, const colorf_t* color, float x, float y, float w, float h, float r);
     mat4x4 mvp; // model * view * projection
+    rectf_t clipping; // current clip rectangle, w == 0 when drawing is not clipped
 } dc_t;
 
 extern dc_t dc;
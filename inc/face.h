@@ -0,0 +1,61 @@
+#pragma once
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "c.h"
+#include "stb_inc.h"
+#include "stb_truetype.h"
+
+begin_c
+
+/* Faces registry: ttf asset is mapped (decompressed for "*.ttf.lz4") and
+   parsed by stbtt_InitFont() once per face and shared by all fonts of that
+   face. Faces are reference counted by name and unmapped when the last
+   reference is closed, keep a face open while loading several sizes of it.
+   face_font() hands out reference counted glyph cache fonts per pixel
+   height. Codepoints missing in a face resolve through its fallback chain
+   into the same glyph cache pages.
+   face_open() and face_close() are thread safe, face_font() and
+   face_font_release() are not. */
+
+typedef struct app_s app_t;
+typedef struct font_s font_t;
+typedef struct face_s face_t;
+
+enum { FACE_MAX_FONTS = 8 }; // distinct pixel heights handed out per face
+
+typedef struct face_s {
+    char name[128];   // asset name
+    app_t* a;
+    void* asset;
+    const void* data;
+    int bytes;
+    void* ttf;        // decompressed "*.ttf.lz4"
+    stbtt_fontinfo fi;
+    int refs;
+    face_t* fallback; // next face of the chain (referenced by this face) or null
+    font_t* fonts[FACE_MAX_FONTS]; // handed out by face_font()
+    face_t* next;     // in registry
+} face_t;
+
+face_t* face_open(app_t* a, const char* name); // returns null and sets errno on failure
+
+void face_close(face_t* face);
+
+// appends fallback to the end of face chain, affects fonts created after the call
+int face_fallback(face_t* face, face_t* fallback); // EINVAL for cycles, ENOSPC for too long chain
+
+font_t* face_font(face_t* face, int height_in_pixels); // returns null and sets errno on failure
+
+void face_font_release(font_t* f);
+
+void faces_deallocate(); // deletes glyph cache textures of all face fonts on hidden()
+
+end_c
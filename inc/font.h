@@ -17,6 +17,15 @@
 
 begin_c
 
+typedef struct app_s app_t;
+typedef struct glyph_cache_s glyph_cache_t;
+
+typedef struct font_kerning_pair_s { // glyph indices relative to font.from
+    uint16_t left;  // 0xFFFF for empty hash table entry
+    uint16_t right;
+    float kern;     // in atlas pixels
+} font_kerning_pair_t;
+
 typedef struct font_s {
     int   from;   // first glyph index
     int   count;  // number of glyphs
@@ -29,9 +38,44 @@ typedef struct font_s {
     stbtt_fontinfo fi;
     void* chars;  // per character info
     texture_t atlas;
+    glyph_cache_t* cache; // not null for fonts with glyphs rasterized on demand
+    struct face_s* face;  // parsed ttf, cached fonts keep it open (see face.h)
+    int refs;       // face_font() references
+    app_t* a;       // baked fonts keep "*.fnt" asset mapped:
+    void* asset;
+    const void* data;
+    int bytes;
+    bool  sdf;      // atlas is signed distance field, one atlas for all sizes
+    int   spread;   // sdf: distance in atlas pixels encoded in [0..255] range
+    float scale;    // sdf: rendered size relative to atlas glyphs size
+    struct font_s* base; // sdf: scaled font shares atlas and chars of the base font
+    bool  baked;    // chars and atlas pixels are in the mapped asset
+    float* advances;  // [count] dense advances table in atlas pixels
+    float  monospace; // advance of every glyph of monospaced font or 0
+    font_kerning_pair_t* kerning; // hash table of kerning pairs or null
+    int    kerning_capacity; // power of 2
 } font_t;
 
-typedef struct app_s app_t;
+/* Baked font assets "*.fnt" (see tools/font_bake.c) are font_baked_header_t
+   followed by stbtt_packedchar[count], font_kerning_pair_t[kerning]
+   and w * h atlas pixels */
+
+#define FONT_BAKED_MAGIC "FNT2"
+
+typedef struct font_baked_header_s {
+    char  magic[4]; // FONT_BAKED_MAGIC
+    int   height;
+    int   from;
+    int   count;
+    float em;
+    float ascent;
+    float descent;
+    float baseline;
+    int   spread; // > 0 for signed distance field atlas
+    int   w;      // atlas width and height
+    int   h;
+    int   kerning; // kerning hash table capacity or 0
+} font_baked_header_t;
 
 int font_find_glyph_index(font_t* f, int unicode_codepoint); // returns -1 if glyph not found
 
@@ -39,8 +83,26 @@ int font_find_glyph_index(font_t* f, int unicode_codepoint); // returns -1 if gl
 
 int font_load_asset(font_t* f, app_t* a, const char* name, int height_in_pixels, int from, int count);
 
+// any unicode codepoint, glyphs are rasterized on first use into glyph cache pages (see glyph_cache.h)
+int font_load_asset_cached(font_t* f, app_t* a, const char* name, int height_in_pixels);
+
+// glyphs are rendered at height_in_pixels as signed distance field with linear filtering
+int font_load_asset_sdf(font_t* f, app_t* a, const char* name, int height_in_pixels, int from, int count);
+
+// maps baked asset, no ttf parsing or rasterization, returns ENOENT if asset does not exist
+int font_load_baked(font_t* f, app_t* a, const char* name);
+
+// initializes f to render sdf font at any height, f must be disposed before sdf font
+int font_scaled(font_t* f, font_t* sdf, int height_in_pixels);
+
+int font_allocate(font_t* f); // uploads atlas texture on shown()
+
+void font_deallocate(font_t* f); // deletes atlas and glyph cache textures on hidden()
+
 float font_text_width(font_t* f, const char* text, int count); // count == -1, use strlen(text)
 
+float font_kerning(font_t* f, int left, int right); // in pixels for two subsequent codepoints
+
 void font_dispose(font_t* font);
 
 end_c
@@ -28,7 +28,9 @@ begin_c
 // all functions 0 in success or last glGetError() if failed
 
 int gl_allocate(int *ti);
+int gl_linear(int ti); // textures are GL_NEAREST filtered by default
 int gl_update(int ti, int w, int h, int bpp, const void* data); // bpp - bytes per pixel
+int gl_update_sub(int ti, int x, int y, int w, int h, int bpp, const void* data); // glTexSubImage2D
 int gl_delete_texture(int ti);
 
 const char* gl_strerror(int gle);
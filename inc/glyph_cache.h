@@ -0,0 +1,94 @@
+#pragma once
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "c.h"
+#include "stb_inc.h"
+#include "stb_truetype.h"
+#include "texture.h"
+
+begin_c
+
+/* Glyph cache rasterizes glyphs on first use into shelf packed 1 byte per
+   pixel atlas pages. When all pages are full the least recently used page
+   is evicted as a whole (glyphs on it are re-rasterized on next use).
+   Only dirty rows of a page are uploaded to GL texture with glTexSubImage2D.
+   Codepoints missing in the primary face are looked up in fallback faces
+   in order and rasterized into the same pages.
+   Pointers returned by find/add are valid until the next add. */
+
+enum {
+    GLYPH_CACHE_PAGE_W  = 512,
+    GLYPH_CACHE_PAGE_H  = 512,
+    GLYPH_CACHE_PAGES   = 4,   // maximum number of pages: 1MB of texture memory
+    GLYPH_CACHE_SHELVES = 64,  // per page
+    GLYPH_CACHE_FALLBACKS = 3  // maximum number of fallback faces
+};
+
+typedef struct glyph_face_s {
+    const stbtt_fontinfo* fi;
+    float scale; // for the same pixel height as primary face
+} glyph_face_t;
+
+typedef struct glyph_s {
+    int   codepoint; // -1 for empty hash table slot
+    int   page;      // -1 for glyphs without pixels (e.g. space)
+    float x0, y0, x1, y1; // bitmap box relative to the pen position on baseline
+    float s0, t0, s1, t1; // texture coordinates
+    float advance;
+} glyph_t;
+
+typedef struct glyph_shelf_s {
+    int x; // first unused column
+    int y;
+    int h;
+} glyph_shelf_t;
+
+typedef struct glyph_page_s {
+    texture_t atlas;
+    glyph_shelf_t shelves[GLYPH_CACHE_SHELVES];
+    int shelves_count;
+    int bottom;    // first row below the last shelf
+    int dirty_y0;  // rows [dirty_y0..dirty_y1) are not uploaded yet
+    int dirty_y1;
+    uint32_t used; // LRU clock of the last use
+} glyph_page_t;
+
+typedef struct glyph_cache_s {
+    glyph_face_t faces[1 + GLYPH_CACHE_FALLBACKS]; // [0] primary face
+    int faces_count;
+    glyph_page_t pages[GLYPH_CACHE_PAGES];
+    int pages_count;
+    glyph_t* glyphs; // open addressing hash table by codepoint
+    int capacity;    // power of 2
+    int count;
+    uint32_t clock;
+    int evictions;   // number of evicted pages
+} glyph_cache_t;
+
+// all functions returns 0 on success posix error otherwise
+
+int glyph_cache_init(glyph_cache_t* c, const stbtt_fontinfo* fi, float scale);
+
+int glyph_cache_fallback(glyph_cache_t* c, const stbtt_fontinfo* fi, float scale); // ENOSPC if too many
+
+glyph_t* glyph_cache_find(glyph_cache_t* c, int codepoint); // null if not cached yet
+
+glyph_t* glyph_cache_add(glyph_cache_t* c, int codepoint); // rasterizes, may evict a page, null on ENOMEM
+
+float glyph_cache_advance(glyph_cache_t* c, int codepoint); // does not rasterize
+
+int glyph_cache_upload(glyph_cache_t* c, int page); // GL thread only
+
+void glyph_cache_deallocate(glyph_cache_t* c); // deletes GL textures, must be called on hidden()
+
+void glyph_cache_dispose(glyph_cache_t* c);
+
+end_c
@@ -0,0 +1,79 @@
+#pragma once
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "ui.h"
+
+begin_c
+
+/* Layout tree positions ui elements instead of hard coded coordinates.
+   Layout is done in two passes: measure pass computes desired size of
+   nodes bottom up and caches it in the node, arrange pass assigns bounds
+   top down with ui.set_bounds() and skips subtrees whose bounds did not
+   change since the last arrange. layout_invalidate() drops cached results
+   of a node and its ancestors only, so a change in one widget re-measures
+   a single path of the tree.
+   Node ui may be null for containers that only position their children,
+   otherwise ui of the children must be children of the nearest ancestor
+   node ui (coordinates passed to arrange are relative to it).
+   Hidden ui elements keep their space. Layout nodes are not allocated,
+   same as ui_t they are embedded by the caller. */
+
+enum {
+    LAYOUT_LEAF   = 0, // ui element of its own size
+    LAYOUT_STACK  = 1, // children on top of each other
+    LAYOUT_ROW    = 2, // children left to right
+    LAYOUT_COLUMN = 3, // children top to bottom
+    LAYOUT_GRID   = 4  // children left to right wrapping every `columns`
+};
+
+enum { // alignment in the cell (across the main axis for row and column)
+    LAYOUT_START  = 0,
+    LAYOUT_CENTER = 1,
+    LAYOUT_END    = 2,
+    LAYOUT_FILL   = 3
+};
+
+typedef struct layout_s layout_t;
+
+typedef struct layout_s {
+    int kind;
+    ui_t* u;       // may be null for containers
+    float w, h;    // leaf desired size, initialized from ui
+    void (*measure)(layout_t* l, float* w, float* h); // leaf desired size, overrides w, h
+    float padding; // around children
+    float gap;     // between children, rows and columns
+    int columns;   // grid only
+    float weight;  // share of extra space along row or column main axis, 0 for none
+    int align;
+    layout_t* parent;
+    layout_t* next; // next sibling
+    layout_t* children;
+    // implementation:
+    struct { float w, h; bool valid; } measured;
+    struct { float x, y, w, h; bool valid; } arranged;
+} layout_t;
+
+void layout_init(layout_t* l, int kind, ui_t* u);
+
+void layout_add(layout_t* l, layout_t* child); // appends child
+
+void layout_remove(layout_t* l, layout_t* child);
+
+// desired size of the node or its subtree changed: re-measure on next arrange
+void layout_invalidate(layout_t* l);
+
+// drops all cached measurements e.g. after font or DPI change
+void layout_invalidate_all(layout_t* l);
+
+// measures when necessary and arranges the subtree, x, y relative to ui of the ancestor
+void layout_arrange(layout_t* l, float x, float y, float w, float h);
+
+end_c
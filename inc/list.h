@@ -0,0 +1,77 @@
+#pragma once
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "ui.h"
+#include "ui_store.h"
+
+begin_c
+
+/* Virtualized list (or grid of `columns` items per row) of data source items.
+   Only views of the items in rows intersecting the list bounds (plus
+   LIST_OVERSCAN rows above and below) exist. Views are pooled ui elements
+   recycled as the list scrolls: bind() is called every time a view is
+   assigned to an item and must set up everything the view draws.
+   Rows are row_height pixels tall when height() is null. Otherwise
+   row_height is the estimate for rows that were not measured yet: rows are
+   measured by blocks of LIST_BLOCK when they are scrolled into view, and
+   sums of block heights are kept in a Fenwick tree, so memory does not
+   depend on the number of rows beyond 9 bytes per block. */
+
+enum {
+    LIST_BLOCK    = 256, // rows measured together
+    LIST_OVERSCAN = 2    // rows bound above and below the visible ones
+};
+
+typedef struct list_s list_t;
+
+typedef struct list_s {
+    ui_t u;
+    int   (*count)(list_t* l); // number of items
+    float (*height)(list_t* l, int row); // of the row, null for row_height
+    void  (*bind)(list_t* l, ui_t* view, int item); // sets up recycled view for the item
+    float row_height; // of all rows or estimate for height()
+    int columns;      // items per row, 1 for list
+    double offset;    // scroll position: pixels from the top of the content
+    const colorf_t* background; // null: not filled
+    // implementation:
+    ui_store_t store; // recycled views
+    ui_t** views;
+    int* items;       // bound to views, -1 for free views
+    int views_count;
+    int views_capacity;
+    ui_t** slots;     // scratch: views by item in range
+    int slots_capacity;
+    int total;        // items at the time of list_reload()
+    int rows;
+    int blocks;
+    double* tree;     // Fenwick tree of block heights
+    byte* measured;   // blocks
+    float laid_w;     // list size at the time of last update
+    float laid_h;
+    bool pressed;
+    bool dragging;    // moved past touch slop, views do not see the pointer
+    float drag_y;     // screen
+} list_t;
+
+void list_init(list_t* l, ui_t* parent, void* that, float x, float y, float w, float h);
+
+// data source count or items changed: re-measures rows and rebinds all views, 0 or ENOMEM
+int list_reload(list_t* l);
+
+void list_scroll(list_t* l, double offset); // clamped to content
+
+void list_invalidate_row(list_t* l, int row); // row height or items of the row changed
+
+double list_content_height(list_t* l);
+
+void list_done(list_t* l);
+
+end_c
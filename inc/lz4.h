@@ -0,0 +1,49 @@
+#pragma once
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "rt.h"
+
+begin_c
+
+/* LZ4 frame decoder https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md
+   Assets are expected to be compressed with the stock command line tool:
+       lz4 -9 --content-size file file.lz4
+   Content size in the frame header is required to allocate destination.
+   Decoding is done block by block directly into the destination buffer
+   (linked blocks use already decoded output as dictionary) thus there
+   is no intermediate copy. Decoder has no global state and is safe to
+   run on any thread. Header, block and content checksums are skipped
+   (assets are verified at build time and mapped read-only). */
+
+typedef struct lz4_stream_s {
+    const byte* data;  // compressed frame
+    int   bytes;
+    int   position;    // in compressed frame
+    byte* output;      // destination
+    int   capacity;    // destination capacity in bytes
+    int   decoded;     // number of bytes already decoded into output
+    int64_t content_size; // -1 if not present in frame header
+    int   block_max;   // maximum size of decoded block
+    bool  block_checksum;
+    bool  content_checksum;
+} lz4_stream_t;
+
+// all functions return 0 on success or posix error otherwise
+
+int lz4_stream_init(lz4_stream_t* s, const void* data, int bytes); // parses frame header
+int lz4_stream_output(lz4_stream_t* s, void* output, int capacity); // set destination
+int lz4_stream_next(lz4_stream_t* s); // decode next block, ENODATA after the last block
+int lz4_decode(const void* data, int bytes, void* output, int capacity, int *decoded); // whole frame
+int lz4_decode_allocate(const void* data, int bytes, void* *output, int *decoded); // caller deallocate()s output
+
+bool lz4_is_compressed(const char* name); // true if asset name ends with ".lz4"
+
+end_c
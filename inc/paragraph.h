@@ -0,0 +1,57 @@
+#pragma once
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "rt.h"
+
+begin_c
+
+/* Paragraph layout of UTF-8 text: lines are broken on '\n' and wrapped
+   on spaces to fit the width (words longer than the width are broken
+   between codepoints). Layout is done in two passes and cached in the
+   paragraph: measure pass computes x of every byte from the paragraph
+   start and is redone only when the font, its height or the text change;
+   break pass is redone when only the width changes. */
+
+typedef struct font_s font_t;
+
+typedef struct paragraph_line_s {
+    int start;   // byte offset of the first character in the text
+    int bytes;   // without trailing spaces and line break
+    float width;
+} paragraph_line_t;
+
+typedef struct paragraph_s {
+    font_t* font;
+    int height;   // of the font at the time of layout
+    char* text;   // copy of the text
+    int bytes;
+    float width;  // wrap width, <= 0 for no wrapping
+    paragraph_line_t* lines;
+    int count;    // at least one line
+    float w;      // width of the widest line
+    float h;      // count * font height
+    float* x;     // [bytes + 1] x of each character from the paragraph start
+    // implementation:
+    int capacity; // of text and x
+    int lines_capacity;
+} paragraph_t;
+
+// returns 0 or ENOMEM, bytes == -1 for strlen(text)
+int paragraph_layout(paragraph_t* p, font_t* f, const char* text, int bytes, float width);
+
+// x of the character at the text offset relative to the start of its line
+static inline_c float paragraph_x(paragraph_t* p, int line, int offset) {
+    return p->x[offset] - p->x[p->lines[line].start];
+}
+
+void paragraph_dispose(paragraph_t* p);
+
+end_c
@@ -0,0 +1,56 @@
+#pragma once
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "ui.h"
+#include "animation.h"
+
+begin_c
+
+/* Kinetic scroll container. Children are added to `content` (not to the
+   scroll itself) and content size is set by scroll_content_size(). Content
+   is clipped to the scroll bounds and translated with ui.scroll(): content
+   bounds stay put, touch and focus hit testing see scrolled children where
+   they are drawn.
+   Dragging follows the finger with rubber band resistance past the edges.
+   On release velocity is estimated from the last SCROLL_SAMPLES touch samples
+   and the content flings with exponential friction, springs back from
+   overscroll and comes to rest on whole pixels. Physics steps on animation
+   frames only while the content moves. Visible children are redrawn on
+   every scrolled frame (culled by the frame clip). */
+
+enum { SCROLL_SAMPLES = 8 }; // touch samples for velocity estimate
+
+typedef struct scroll_s {
+    ui_t u;
+    ui_t content;     // container of scrolled children, w, h is content size
+    pointf_t offset;  // scroll position: content pixels left and above of the scroll bounds
+    const colorf_t* background; // null: not filled
+    // implementation:
+    pointf_t velocity; // of offset, pixels per second
+    struct { pointf_t xy; uint64_t ns; } samples[SCROLL_SAMPLES]; // ring of screen touch samples
+    int sample;        // next sample index
+    int samples_count;
+    bool pressed;
+    bool dragging;     // moved past touch slop
+    pointf_t drag;     // last screen touch
+    animation_t motion; // physics steps
+    uint64_t step_ns;  // app time of the last physics step
+} scroll_t;
+
+void scroll_init(scroll_t* s, ui_t* parent, void* that, float x, float y, float w, float h);
+
+void scroll_content_size(scroll_t* s, float w, float h); // keeps offset in range
+
+void scroll_to(scroll_t* s, float x, float y); // stops fling, clamped to the content
+
+void scroll_done(scroll_t* s);
+
+end_c
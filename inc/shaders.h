@@ -44,11 +44,16 @@ typedef struct shaders_s {
     int ring_rgba;
     int ring_ro2;
     int ring_ri2;
+    int sdf; // signed distance field 8 bit GL_ALPHA tex * rgba color
+    int sdf_mvp;
+    int sdf_tex;
+    int sdf_rgba;
+    int sdf_smoothing;
 } shaders_t;
 
 extern shaders_t shaders;
 
-int  shaders_init();
+int  shaders_init(); // uses program binaries cache when available (GLES 3.0+)
 void shaders_dispose();
 
 end_c
@@ -0,0 +1,54 @@
+#pragma once
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "rt.h"
+
+begin_c
+
+/* Tasks graph: tasks that are not marked `gl' run concurrently on worker
+   threads as soon as all their dependencies are done. `gl' tasks run on
+   the thread that called tasks_run() (the one with current GL context)
+   and also wait only on their own dependencies.
+   tasks_run() returns when all tasks are done and logs per task timing. */
+
+typedef struct task_s task_t;
+
+enum {
+    TASK_MAX_DEPENDENCIES = 4,
+    TASKS_MAX_WORKERS = 7
+};
+
+typedef struct task_s {
+    const char* name;
+    void (*run)(task_t* t);
+    void* that;
+    bool gl; // must run on the calling (GL) thread
+    task_t* deps[TASK_MAX_DEPENDENCIES]; // null or tasks from the same graph
+    // implementation:
+    int pending; // number of unfinished dependencies
+    int state;
+    int thread;  // 0 for GL thread, 1.. for workers
+    uint64_t start_ns;
+    uint64_t end_ns;
+} task_t;
+
+void tasks_run(const char* label, task_t* tasks[], int count); // label for timing report
+
+uint64_t tasks_time_ns(); // monotonic clock
+
+/* Runs body(that, i) for every i in [0..count) on the calling thread and
+   up to TASKS_MAX_WORKERS worker threads. Bodies must be independent.
+   Returns when all bodies are done: 0 or the first non zero result
+   (no new bodies are started after an error). */
+
+int tasks_parallel_for(int count, int (*body)(void* that, int i), void* that);
+
+end_c
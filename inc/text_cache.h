@@ -0,0 +1,56 @@
+#pragma once
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "dc.h"
+
+begin_c
+
+/* Text runs cache: glyph quads of a text run relative to the run origin
+   and its advance keyed by (font, hash, length) of the text. dc.text()
+   reuses cached runs with translation only. Runs not used for
+   TEXT_CACHE_MAX_AGE frames are evicted by text_cache_frame() and least
+   recently used runs are evicted when the cache is over the byte budget.
+   UI thread only. */
+
+enum {
+    TEXT_CACHE_BUDGET  = 256 * 1024, // bytes
+    TEXT_CACHE_MAX_AGE = 120 // frames
+};
+
+typedef struct text_run_s text_run_t;
+
+typedef struct text_run_s {
+    text_run_t* next; // in hash bucket
+    font_t* font;
+    font_t* base;     // font->base at the time run was cached
+    uint64_t hash;
+    int bytes;        // text length
+    int count;        // number of glyphs (quads)
+    float advance;
+    uint32_t used;    // frame of the last use
+    int size;         // allocated bytes
+    quadf_t* quads;   // [count * 4] relative to the run origin
+    char* text;       // copy of the text
+} text_run_t;
+
+const text_run_t* text_cache_find(font_t* f, const char* text, int bytes); // null if not cached
+
+// copies quads, returns null if the run does not fit into budget
+const text_run_t* text_cache_put(font_t* f, const char* text, int bytes,
+                                 const quadf_t* quads, int count, float advance);
+
+void text_cache_frame(); // once per frame, ages and evicts unused runs
+
+void text_cache_remove(font_t* f); // runs of the font or fonts scaled from it
+
+void text_cache_clear();
+
+end_c
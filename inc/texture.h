@@ -25,6 +25,18 @@ typedef struct texture_s {
     void* data;
 } texture_t;
 
+/* Decoded texture cache assets "*.lz4" are texture_cache_header_t followed by
+   LZ4 frame of w * h * comp bytes of raw pixels (see lz4.h) */
+
+#define TEXTURE_CACHE_MAGIC "TXC1"
+
+typedef struct texture_cache_header_s {
+    char magic[4]; // TEXTURE_CACHE_MAGIC
+    int w;
+    int h;
+    int comp;
+} texture_cache_header_t;
+
 typedef struct app_s app_t;
 
 int texture_allocate(texture_t* b);
@@ -35,7 +47,11 @@ int texture_update(texture_t* b);
 
 int texture_allocate_and_update(texture_t* b);
 
-int texture_load_asset(texture_t* b, app_t* a, const char* name);
+int texture_linear(texture_t* b); // GL_LINEAR filtering (e.g. for distance fields)
+
+int texture_update_rows(texture_t* b, int y, int h); // uploads only rows [y..y + h) of data
+
+int texture_load_asset(texture_t* b, app_t* a, const char* name); // no GL calls, safe on worker thread
 
 void texture_dispose(texture_t* b);
 
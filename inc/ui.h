@@ -31,6 +31,7 @@ enum {
     MOUSE_MOVE         = TOUCH_MOVE,
     MOUSE_BUTTON_DOWN  = TOUCH_DOWN,
     MOUSE_BUTTON_UP    = TOUCH_UP,
+    MOUSE_WHEEL        = 0x0008, // and trackball, see app.wheel_x, app.wheel_y
 
     // keyboad state (flags) not to be confused with KEY_CODE_SHIFT, KEY_CODE_ALT ...
     KEYBOARD_SHIFT       = 0x0001,
@@ -86,7 +87,9 @@ enum {
     UI_KIND_DECOR     = 1,
     UI_KIND_BUTTON    = 2,
     UI_KIND_SLIDER    = 3,
-    UI_KIND_EDIT      = 4
+    UI_KIND_EDIT      = 4,
+    UI_KIND_LIST      = 5,
+    UI_KIND_SCROLL    = 6
 };
 
 typedef struct app_s app_t;
@@ -105,21 +108,38 @@ typedef struct timer_callback_s {
     int id; // timer id is only valid after succesful time
     uint64_t ns; // period in nanoseconds
     uint64_t last_fired; // monotonic ns since app start_time, must be zero before calling set_timer()
+    // implementation:
+    uint64_t deadline;   // monotonic ns of the next callback
+    int position;        // in the timers heap while id != 0
 } timer_callback_t;
 
 /* theory of operations:
    1 Containers forward calls to children.
    2 Terminal leaves can impelement draw()
    3 Container may implement draw() but need to call draw_children() inside it
-   4 screen_touch() is called for all (even hidden components). Used to "disarm" pressed buttons
+   4 touch(TOUCH_DOWN) may ui.capture() the pointer: following moves and up go directly to
+     the capturing ui (x, y relative to it, may be outside of its bounds) instead of hit
+     testing and enter() tells when the pointer leaves or re-enters ui bounds (to "disarm"
+     pressed buttons). Capture taken later (e.g. drag started) is exclusive: other capturing
+     ui see the pointer leave and lose it. Capture ends on up, ui.hide() or ui.remove()
    5 keyboard is called on all containers and terminal leaves. Compare yourself to app.focus to accept input
+   6 absolute bounds are cached and widgets attached to app.root are kept in a spatial index
+     for touch and focus hit testing, change x, y, w, h only via ui.set_bounds() to keep both
+     up to date (DEBUG build asserts on stale cache). ui.scroll() shifts children by offset
+     without moving them: their bounds are cached relative to the scrolling ui and they are hit
+     tested by a tree walk under it instead of the index, scrolling costs only ui.invalidate()
+   7 ui.invalidate() adds ui bounds to app.invalid, next frame is clipped to it and draws only
+     children that intersect it (and must not draw outside of own bounds), the rest of the
+     previous frame pixels is preserved
+   8 ui.hide() changes hidden and invalidates ui, ui elements allocated from ui_store must
+     use it instead of writing hidden directly
 */
 
 typedef struct ui_s {
     void (*draw)(ui_t* u); // calls draw_children
     void (*draw_children)(ui_t* u);
     bool (*touch)(ui_t* u, int touch_flags, float x, float y); // x,y in ui coordinates, return true if consumed
-    void (*screen_touch)(ui_t* u, int touch_flags, float screen_x, float screen_y); // x,y screen coordinates
+    void (*enter)(ui_t* u, bool inside); // captured pointer entered or left ui bounds
     bool (*keyboard)(ui_t* u, int flags, int ch); // return true if consumed
     void (*focus)(ui_t* u, bool gain);
     int kind;
@@ -128,10 +148,20 @@ typedef struct ui_s {
     bool hidden;
     bool focusable;
     bool decor; // draw this ui element on top of children
+    bool invalid; // needs redraw, ui.invalidate() sets it on ui and all its ancestors
+    pointf_t offset; // children are shifted left and up by it, set by ui.scroll()
     ui_t* parent;
     app_t* a;
     ui_t* next; // next sibling
     ui_t* children; // linked list of children
+    // implementation:
+    rectf_t screen; // cached bounds relative to frame children or absolute, recomputed when dirty
+    ui_t* frame;    // nearest scrolling ancestor or null
+    bool scrolls;   // ui.scroll() was called: descendants are not in the spatial index
+    bool dirty;     // set on moves, ui.add() and ui.remove(), propagates to descendants
+    struct { int x0, y0, x1, y1; bool on; int order, last; } indexed; // cells and pre-order in spatial index (see ui.c)
+    struct ui_store_s* store; // pool the ui was allocated from or null (see ui_store.h)
+    int position;             // in store arrays
 } ui_t;
 
 typedef struct {
@@ -139,10 +169,15 @@ typedef struct {
     void (*done)(ui_t* u); // remove() ui from parent and dispose it
     void (*add)(ui_t* u, ui_t* child, float x, float y, float w, float h);
     void (*remove)(ui_t* u, ui_t* child);
+    void (*set_bounds)(ui_t* u, float x, float y, float w, float h); // x, y relative to parent
+    void (*hide)(ui_t* u, bool hidden);
     pointf_t (*screen_xy)(ui_t* u); // return ui element screen coordinates
+    rectf_t (*screen_rect)(ui_t* u); // return ui element screen bounds
+    void (*invalidate)(ui_t* u); // redraw ui bounds on the next frame
     bool (*set_focus)(ui_t* u, int x, int y); // returns true if focus was set
     bool (*dispatch_touch)(ui_t* u, int touch_flags, float x, float y); // x,y in ui coordinates
-    void (*dispatch_screen_touch)(ui_t* u, int touch_flags, float screen_x, float screen_y); // x,y screen coordinates
+    void (*capture)(ui_t* u); // from touch(): moves and up of the pointer go to u till up
+    void (*scroll)(ui_t* u, float x, float y); // shifts children by -x, -y, caller invalidates
 } ui_interface_t;
 
 extern const ui_interface_t ui;
@@ -0,0 +1,90 @@
+#pragma once
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "ui.h"
+
+begin_c
+
+/* Optional widget store for large dynamic trees (10^4..10^5 elements, e.g.
+   rows of a document) under a single root container. Elements are allocated
+   from a pool of blocks instead of being embedded one by one and remain
+   ordinary ui_t: ui.* calls, draw(), touch() etc. work as for any ui.
+   Hot fields of the pooled elements (bounds, hidden, decor, focusable, kind
+   and parent) are also kept in contiguous arrays in tree pre-order. Subtree
+   of the element at position i occupies positions [i, end[i]), so a move
+   recomputes bounds of the subtree in one linear pass, and hit testing and
+   culling scan dense arrays skipping whole subtrees instead of chasing
+   next/children pointers.
+   ui.c keeps the arrays current on ui.set_bounds(), ui.hide(), ui.add() and
+   ui.remove(). When every descendant of the root is pooled ui.c itself marks
+   moved subtrees dirty, culls drawn children and hit tests tree walk touch
+   dispatch over the arrays. Structure changes only mark arrays for rebuild on the next
+   query. kind, decor and focusable are read on rebuild: set them right
+   after ui_store_allocate(). DEBUG build asserts on stale arrays.
+   Pooled elements must be added to the root or to other pooled elements of
+   the same store. Coordinates of the queries are relative to the root. */
+
+enum {
+    UI_STORE_HIDDEN    = 0x1,
+    UI_STORE_DECOR     = 0x2,
+    UI_STORE_FOCUSABLE = 0x4
+};
+
+typedef struct ui_store_s {
+    ui_t* root;      // not pooled container of the elements
+    // pre-order arrays of pooled elements attached to the root:
+    ui_t** ui;
+    rectf_t* bounds; // relative to parent
+    pointf_t* xy;    // relative to the root
+    int* parent;     // position of parent or -1 for children of the root
+    int* end;        // position after the last descendant
+    byte* flags;     // UI_STORE_*
+    byte* kind;
+    int count;
+    // implementation:
+    bool ordered;    // arrays are up to date with tree structure
+    bool mixed;      // not pooled ui under the root or pooled elements
+    int changes;     // of tree structure, positions of earlier queries are stale when it differs
+    int capacity;    // of arrays == number of pooled elements
+    ui_t** blocks;   // pool
+    int blocks_count;
+    ui_t* free;      // list of free pooled elements linked by next
+} ui_store_t;
+
+void ui_store_init(ui_store_t* s, ui_t* root);
+
+/* removes pooled elements that are still in use from their parents and frees the pool,
+   not pooled descendants of the elements must be done() before */
+void ui_store_dispose(ui_store_t* s);
+
+// returns ui.init()-ed element or null and sets errno to ENOMEM
+ui_t* ui_store_allocate(ui_store_t* s, ui_t* parent, void* that, float x, float y, float w, float h);
+
+void ui_store_deallocate(ui_t* u); // u must not have children
+
+/* visible elements with visible ancestors that contain (x, y), same set and order
+   as ui.dispatch_touch() tree walk, returns count, may be more than n */
+int ui_store_hits(ui_store_t* s, float x, float y, ui_t** hits, int n);
+
+/* visible elements with visible ancestors intersecting the rectangle in tree
+   pre-order (draw order, decor not reordered), returns count, may be more than n */
+int ui_store_cull(ui_store_t* s, rectf_t r, ui_t** visible, int n);
+
+// called by ui.c:
+
+/* store with every descendant of u (the root or pooled element) in its arrays
+   at positions [*first, *end) or null, order: rebuild stale arrays first */
+ui_store_t* ui_store_subtree(ui_t* u, bool order, int* first, int* end);
+
+void ui_store_moved(ui_t* u);   // on bounds and hidden change
+void ui_store_changed(ui_t* u); // on add and remove
+
+end_c
@@ -0,0 +1,76 @@
+#pragma once
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "rt.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+begin_c
+
+enum { UTF8_REPLACEMENT = 0xFFFD };
+
+// returns number of leading 7-bit ASCII bytes in s[0..n) scanning 16 (or 32 with AVX2) bytes at a time
+
+static inline_c int utf8_ascii(const char* s, int n) {
+    const byte* p = (const byte*)s;
+    int i = 0;
+    #if defined(__AVX2__)
+    for (; i + 32 <= n; i += 32) {
+        const uint32_t m = (uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)(p + i)));
+        if (m != 0) { return i + __builtin_ctz(m); }
+    }
+    #endif
+    #if defined(__SSE2__)
+    for (; i + 16 <= n; i += 16) {
+        const uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(p + i)));
+        if (m != 0) { return i + __builtin_ctz(m); }
+    }
+    #elif defined(__aarch64__)
+    for (; i + 16 <= n && vmaxvq_u8(vld1q_u8(p + i)) < 0x80; i += 16) { }
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t v = vld1q_u8(p + i);
+        const uint64x1_t m = vreinterpret_u64_u8(vorr_u8(vget_low_u8(v), vget_high_u8(v)));
+        if ((vget_lane_u64(m, 0) & 0x8080808080808080ULL) != 0) { break; }
+    }
+    #endif
+    while (i < n && p[i] < 0x80) { i++; } // tail and position inside 16 bytes block on NEON
+    return i;
+}
+
+/* decodes single codepoint at s < e into *cp, returns number of bytes consumed (>= 1).
+   Invalid, overlong, truncated sequences, surrogates and codepoints above
+   U+10FFFF are decoded as UTF8_REPLACEMENT. */
+
+static inline_c int utf8_decode(const char* s, const char* e, int* cp) {
+    const byte* p = (const byte*)s;
+    const int b0 = p[0];
+    if (b0 < 0x80) { *cp = b0; return 1; }
+    // 0xC0, 0xC1 are always overlong and 0xF5..0xFF are above U+10FFFF
+    const int n = b0 < 0xC2 ? 0 : b0 < 0xE0 ? 2 : b0 < 0xF0 ? 3 : b0 < 0xF5 ? 4 : 0;
+    if (n == 0) { *cp = UTF8_REPLACEMENT; return 1; }
+    static const int masks[] = { 0, 0, 0x1F, 0x0F, 0x07 };
+    static const int least[] = { 0, 0, 0x80, 0x800, 0x10000 }; // shortest form
+    int c = b0 & masks[n];
+    for (int i = 1; i < n; i++) {
+        if (p + i >= (const byte*)e || (p[i] & 0xC0) != 0x80) { *cp = UTF8_REPLACEMENT; return i; }
+        c = (c << 6) | (p[i] & 0x3F);
+    }
+    const bool valid = c >= least[n] && c <= 0x10FFFF && (c < 0xD800 || c > 0xDFFF);
+    *cp = valid ? c : UTF8_REPLACEMENT;
+    return n;
+}
+
+end_c
@@ -0,0 +1,114 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "animation.h"
+#include "app.h"
+
+begin_c
+
+static struct {
+    animation_t* list;    // linked animations, stopped ones are unlinked by the next frame
+    animation_t* started; // during frame: started by step() or done(), joins the list after it
+    bool framing;
+} animations;
+
+static void animation_unlink(animation_t** list, animation_t* a) {
+    animation_t** p = list;
+    while (*p != null && *p != a) { p = &(*p)->next; }
+    if (*p == a) { *p = a->next; }
+    a->next = null;
+    a->linked = false;
+}
+
+void animation_start(animation_t* a) {
+    assertion(a->duration > 0 || a->step != null, "endless animation needs step()");
+    if (!a->linked) {
+        animation_t** list = animations.framing ? &animations.started : &animations.list;
+        a->next = *list;
+        *list = a;
+        a->linked = true;
+    }
+    a->active = true;
+    a->started = false;
+    a->elapsed = 0;
+    sys.animate(app);
+}
+
+void animation_stop(animation_t* a) {
+    a->active = false;
+    // while framing the list is being walked: unlinked at the end of the frame
+    if (a->linked && !animations.framing) { animation_unlink(&animations.list, a); }
+}
+
+static void animation_advance(animation_t* a, uint64_t now) {
+    if (!a->started) {
+        a->start = now;
+        a->started = true;
+    }
+    a->elapsed = now - a->start;
+    bool last = false;
+    float t = 0;
+    if (a->duration > 0) {
+        uint64_t cycle = a->elapsed / a->duration;
+        if (a->repeat != ANIMATION_FOREVER && cycle > (uint64_t)a->repeat) {
+            cycle = a->repeat;
+            t = 1;
+            last = true;
+        } else {
+            t = (float)(a->elapsed % a->duration) / a->duration;
+        }
+        if (a->reverse && (cycle & 1) != 0) { t = 1 - t; }
+    }
+    if (a->value != null) {
+        const float e = a->easing != null ? a->easing(t) : t;
+        *a->value = a->from + (a->to - a->from) * e;
+    }
+    if (a->u != null) { ui.invalidate(a->u); }
+    if (a->step != null) { a->step(a); }
+    if (last && a->active) {
+        a->active = false;
+        if (a->done != null) { a->done(a); } // may start it again
+    }
+}
+
+bool animation_frame(app_t* app) {
+    const uint64_t now = app->time_in_nanoseconds;
+    animations.framing = true;
+    for (animation_t* a = animations.list; a != null; a = a->next) {
+        if (a->active) { animation_advance(a, now); }
+    }
+    animations.framing = false;
+    animation_t** p = &animations.list;
+    while (*p != null) {
+        animation_t* a = *p;
+        if (a->active) {
+            p = &a->next;
+        } else {
+            *p = a->next;
+            a->next = null;
+            a->linked = false;
+        }
+    }
+    *p = animations.started; // appended: they advance from the next frame on
+    animations.started = null;
+    return animations.list != null;
+}
+
+float animation_linear(float t) { return t; }
+
+float animation_ease_in(float t) { return t * t * t; }
+
+float animation_ease_out(float t) { const float s = 1 - t; return 1 - s * s * s; }
+
+float animation_ease_in_out(float t) {
+    return t < 0.5f ? 4 * t * t * t : 1 - 4 * (1 - t) * (1 - t) * (1 - t);
+}
+
+end_c
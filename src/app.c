@@ -13,32 +13,21 @@
 
 begin_c
 
-static bool dispatch_keyboard_shortcuts(ui_t* u, int flags, int keycode) {
-    bool consumed = false;
-    if (u->kind == UI_KIND_BUTTON && !u->hidden) {
-        btn_t* b = (btn_t*)u;
-        int kc = isalpha(keycode) ? tolower(keycode) : keycode;
-        int k = isalpha(b->key) ? tolower(b->key) : b->key;
-        if (!u->hidden && b->key_flags == flags && k == kc) {
-            // TODO: (Leo) if 3 (or more) states checkboxes are required this is the place to do it.
-            //       b->flip = (b->flip + 1) % b->flip_wrap_around;
-            if (b->flip != null) { *b->flip = !*b->flip; }
-            sys.invalidate(u->a);
-            b->click(&b->u);
-            return true; // stop search
-        }
+static bool dispatch_keyboard_shortcuts(int flags, int keycode) {
+    btn_t* b = btn_shortcut(flags, keycode); // hash lookup instead of the tree walk
+    if (b != null) {
+        // TODO: (Leo) if 3 (or more) states checkboxes are required this is the place to do it.
+        //       b->flip = (b->flip + 1) % b->flip_wrap_around;
+        if (b->flip != null) { *b->flip = !*b->flip; }
+        ui.invalidate(&b->u);
+        if (b->click != null) { b->click(&b->u); }
     }
-    ui_t* c = u->children;
-    while (c != null && !consumed) {
-        if (!c->hidden) {
-            consumed = dispatch_keyboard_shortcuts(c, flags, keycode);
-        }
-        c = c->next;
-    }
-    return consumed;
+    return b != null;
 }
 
 static bool dispatch_key_to_children(ui_t* u, int flags, int keycode) {
+    // only direct children of the root (usually one or two) are polled, the
+    // contract in ui.h promises keyboard() to them (e.g. demo content BACK key)
     bool consumed = false;
     ui_t* c = u->children;
     while (!consumed && c != null) {
@@ -59,10 +48,10 @@ bool app_dispatch_key(app_t* a, int flags, int keycode) {
     // if key was not consumed each element in the root votes next
     // because e.g. it may have it's own keyboard shortcuts for actions
     consumed = consumed || dispatch_key_to_children(&a->root, flags, keycode);
-    // and if it is still unconsumed walk the tree down to roots looking for btn shortcuts:
+    // and if it is still unconsumed look for visible btn with the shortcut:
     if (!consumed && (flags & KEYBOARD_KEY_PRESSED)) {
         int f = flags & ~(KEYBOARD_KEY_PRESSED|KEYBOARD_SHIFT|KEYBOARD_NUMLOCK|KEYBOARD_CAPSLOCK);
-        consumed = dispatch_keyboard_shortcuts(&a->root, f, keycode);
+        consumed = dispatch_keyboard_shortcuts(f, keycode);
     }
     return consumed;
 }
@@ -75,7 +64,6 @@ bool app_dispatch_touch(app_t* a, int index, int action, int x, int y) {
                 sys.focus(a, null); // kill focus if no focusable components were found
             }
         }
-        ui.dispatch_screen_touch(&a->root, action, x, y);
         consumed = ui.dispatch_touch(&a->root, action, x, y);
     } else {
         // multi-touch gesture recognizer goes here
@@ -14,6 +14,64 @@
 
 begin_c
 
+enum { BTN_SHORTCUTS_BITS = 6 };
+
+static btn_t* shortcuts[1 << BTN_SHORTCUTS_BITS]; // hash buckets of (key_flags, key)
+
+static int btn_normalized_key(int key) {
+    return 0 <= key && key < 0x80 && isalpha(key) ? tolower(key) : key;
+}
+
+static btn_t** btn_shortcuts_bucket(int key_flags, int key) {
+    // key codes live in the high bits: top bits of the product depend on all of them
+    const uint32_t h = ((uint32_t)btn_normalized_key(key) * 0x9E3779B1U + (uint32_t)key_flags) * 0x85EBCA77U;
+    return &shortcuts[h >> (32 - BTN_SHORTCUTS_BITS)];
+}
+
+static void btn_shortcut_add(btn_t* b) { // bucket order does not matter, see btn_shortcut()
+    btn_t** p = btn_shortcuts_bucket(b->key_flags, b->key);
+    while (*p != null) { p = &(*p)->next_shortcut; }
+    *p = b;
+    b->next_shortcut = null;
+}
+
+static void btn_shortcut_remove(btn_t* b) {
+    btn_t** p = btn_shortcuts_bucket(b->key_flags, b->key);
+    while (*p != null && *p != b) { p = &(*p)->next_shortcut; }
+    if (*p == b) { *p = b->next_shortcut; }
+}
+
+static bool btn_reachable(btn_t* b) { // same buttons tree walk from app root would visit
+    ui_t* u = &b->u;
+    while (u->parent != null && !u->hidden) { u = u->parent; }
+    return u == &app->root;
+}
+
+static bool btn_precedes(ui_t* a, ui_t* b) { // pre-order of the tree walk, a != b
+    int da = 0;
+    int db = 0;
+    for (ui_t* u = a; u->parent != null; u = u->parent) { da++; }
+    for (ui_t* u = b; u->parent != null; u = u->parent) { db++; }
+    while (da > db) { a = a->parent; da--; if (a == b) { return false; } }
+    while (db > da) { b = b->parent; db--; if (a == b) { return true; } }
+    while (a->parent != b->parent) { a = a->parent; b = b->parent; }
+    ui_t* c = a->parent->children;
+    while (c != a && c != b) { c = c->next; }
+    return c == a;
+}
+
+btn_t* btn_shortcut(int key_flags, int key) {
+    const int k = btn_normalized_key(key);
+    btn_t* first = null;
+    for (btn_t* b = *btn_shortcuts_bucket(key_flags, k); b != null; b = b->next_shortcut) {
+        if (b->key_flags == key_flags && btn_normalized_key(b->key) == k && btn_reachable(b)) {
+            // shared shortcuts are rare: only they pay for the tree order comparison
+            if (first == null || btn_precedes(&b->u, &first->u)) { first = b; }
+        }
+    }
+    return first;
+}
+
 static void btn_draw(ui_t* u) {
     assertion(false, "btn is abstract should not be used directly");
 }
@@ -23,29 +81,30 @@ static bool btn_touch(ui_t* u, int touch_action, float x, float y) {
     app_t* a = u->a;
     bool consumed = false;
     if (touch_action & TOUCH_DOWN) {
+        ui.capture(u); // up is delivered even if the finger slides off the button
         b->bitset |= BUTTON_STATE_PRESSED;
-        sys.invalidate(a);
+        ui.invalidate(u);
         consumed = true;
-    } else if (touch_action & TOUCH_UP) {
+    } else if ((touch_action & TOUCH_UP) && (b->bitset & BUTTON_STATE_PRESSED)) { // released inside
         // TODO: (Leo) if we need 3 (or more) state flip this is the place to do it. b->flip = (b->flip + 1) % b->checkbox_wrap_around;
         if (b->flip  != null) { *b->flip = !*b->flip; }
         if (b->click != null) { b->click(u); }
         sys.vibrate(a, EFFECT_CLICK);
         b->bitset &= ~BUTTON_STATE_PRESSED;
-        sys.invalidate(a);
+        ui.invalidate(u);
         consumed = true;
     }
     return consumed;
 }
 
-static void btn_screen_touch(ui_t* u, int touch_action, float x, float y) {
+static void btn_enter(ui_t* u, bool inside) {
     btn_t* b = (btn_t*)u;
-    pointf_t pt = ui.screen_xy(u);
-    bool inside = pt.x <= x && x < pt.x + u->w && pt.y <= y && y < pt.y + u->h;
-    if (!inside && (b->bitset & (BUTTON_STATE_PRESSED|BUTTON_STATE_ARMED) != 0)) {
+    if (inside) {
+        b->bitset |= BUTTON_STATE_PRESSED; // finger came back
+    } else {
         b->bitset &= ~(BUTTON_STATE_PRESSED|BUTTON_STATE_ARMED); // disarm button
-        sys.invalidate(u->a);
     }
+    ui.invalidate(u);
 }
 
 void btn_init(btn_t* b, ui_t* parent, void* that, int key_flags, int key,
@@ -63,10 +122,12 @@ void btn_init(btn_t* b, ui_t* parent, void* that, int key_flags, int key,
     b->u.kind = UI_KIND_BUTTON;
     b->u.draw = btn_draw;
     b->u.touch = btn_touch;
-    b->u.screen_touch = btn_screen_touch;
+    b->u.enter = btn_enter;
+    if (key != 0) { btn_shortcut_add(b); }
 }
 
 void btn_done(btn_t* b) {
+    if (b->key != 0) { btn_shortcut_remove(b); }
     ui.done(&b->u);
     memset(b, 0, sizeof(*b));
 }
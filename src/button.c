@@ -18,8 +18,9 @@ static void button_draw(ui_t* u) {
     btn_t* b = &((button_t*)u)->btn;
     theme_t* theme = &u->a->theme;
     const colorf_t* color = b->bitset & BUTTON_STATE_PRESSED ? theme->color_background_pressed : theme->color_background;
-    pointf_t pt = ui.screen_xy(u);
-    dc.fill(&dc, color, pt.x, pt.y, u->w, u->h);
+    const rectf_t r = ui.screen_rect(u);
+    pointf_t pt = {r.x, r.y};
+    dc.fill(&dc, color, r.x, r.y, r.w, r.h);
     int k = (int)strlen(b->label) + 1;
     const char* mn = b->mnemonic;
     char letter[2] = {};
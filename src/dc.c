@@ -12,6 +12,9 @@
 #include "glh.h"
 #include "shaders.h"
 #include "font.h"
+#include "glyph_cache.h"
+#include "utf8.h"
+#include "text_cache.h"
 #include <GLES/gl.h>
 #include <GLES3/gl3.h>
 
@@ -22,6 +25,8 @@ static uint32_t gl_version; // 0x0003002 for 3.2
 static void init(dc_t* dc);
 static void viewport(dc_t* dc, float x, float y, float w, float h);
 static void dispose(dc_t* dc);
+static void frame(dc_t* dc);
+static void clip(dc_t* dc, float x, float y, float w, float h);
 static void clear(dc_t* dc, const colorf_t* color);
 static void fill(dc_t* dc, const colorf_t* color, float x, float y, float w, float h);
 static void rect(dc_t* dc, const colorf_t* color, float x, float y, float w, float h, float width);
@@ -41,6 +46,8 @@ dc_t dc = {
     init,
     viewport,
     dispose,
+    frame,
+    clip,
     clear,
     fill,
     rect,
@@ -107,14 +114,36 @@ static void init(dc_t* dc) {
     gl_check(glEnableVertexAttribArray(0));
 }
 
+static rectf_t view; // viewport
+
 static void viewport(dc_t* dc, float x, float y, float w, float h) {
     orthographic_projection_2d(dc->mvp, x, y, w, h);
     gl_check(glViewport(x, y, w, h));
+    view = (rectf_t){x, y, w, h};
 }
 
 static void dispose(dc_t* dc) {
 }
 
+static void frame(dc_t* dc) {
+    text_cache_frame();
+}
+
+static void clip(dc_t* dc, float x, float y, float w, float h) {
+    if (w > 0 && h > 0) { // to whole pixels covering the rectangle
+        const int x0 = (int)floorf(x);
+        const int y0 = (int)floorf(y);
+        const int x1 = (int)ceilf(x + w);
+        const int y1 = (int)ceilf(y + h);
+        gl_check(glEnable(GL_SCISSOR_TEST));
+        gl_check(glScissor(view.x + x0, view.y + view.h - y1, x1 - x0, y1 - y0)); // GL origin is bottom left
+        dc->clipping = (rectf_t){x0, y0, x1 - x0, y1 - y0};
+    } else {
+        gl_check(glDisable(GL_SCISSOR_TEST));
+        dc->clipping = (rectf_t){};
+    }
+}
+
 static void clear(dc_t* dc, const colorf_t* color) {
     if (color->a != 0) {
         gl_check(glClearColor(color->r, color->g, color->b, color->a));
@@ -300,24 +329,140 @@ static void line(dc_t* dc, const colorf_t* c, float x0, float y0, float x1, floa
     }
 }
 
-static float text(dc_t* dc, const colorf_t* c, font_t* f, float x, float y, const char* text, int n) {
+static void glyphs(dc_t* dc, const colorf_t* c, glyph_cache_t* gc, int page, quadf_t* quads, int n) {
+    if (n > 0) {
+        int r = glyph_cache_upload(gc, page);
+        assert(r == 0); (void)r;
+        dc->tex4(dc, c, &gc->pages[page].atlas, quads, n);
+    }
+}
+
+static float text_cached(dc_t* dc, const colorf_t* c, font_t* f, float x, float y, const char* text, int n) {
+    // text is utf8 and n is number of bytes, quads are drawn in batches per glyph cache page
+    glyph_cache_t* gc = f->cache;
     quadf_t quads[n * 4];
-    const int w = f->atlas.w;
-    const int h = f->atlas.h;
-    stbtt_packedchar* chars = (stbtt_packedchar*)f->chars;
     int k = 0;
-    for (int i = 0; i < n; i++) {
-        stbtt_aligned_quad q;
-        stbtt_GetPackedQuad(chars, w, h, text[i] - f->from, &x, &y, &q, 0);
-        quadf_t q0 = {q.x0, q.y0, q.s0, q.t0}; quads[k++] = q0;
-        quadf_t q1 = {q.x1, q.y0, q.s1, q.t0}; quads[k++] = q1;
-        quadf_t q2 = {q.x1, q.y1, q.s1, q.t1}; quads[k++] = q2;
-        quadf_t q3 = {q.x0, q.y1, q.s0, q.t1}; quads[k++] = q3;
+    int page = -1; // of pending quads
+    const char* e = text + n;
+    while (text < e) {
+        int cp = 0;
+        text += utf8_decode(text, e, &cp);
+        glyph_t* g = glyph_cache_find(gc, cp);
+        if (g == null) { // rasterizing may evict the page pending quads refer to
+            glyphs(dc, c, gc, page, quads, k / 4);
+            k = 0;
+            g = glyph_cache_add(gc, cp);
+        }
+        if (g == null) {
+            x += glyph_cache_advance(gc, cp);
+        } else {
+            if (g->page >= 0) {
+                if (g->page != page) {
+                    glyphs(dc, c, gc, page, quads, k / 4);
+                    k = 0;
+                    page = g->page;
+                }
+                quadf_t q0 = {x + g->x0, y + g->y0, g->s0, g->t0}; quads[k++] = q0;
+                quadf_t q1 = {x + g->x1, y + g->y0, g->s1, g->t0}; quads[k++] = q1;
+                quadf_t q2 = {x + g->x1, y + g->y1, g->s1, g->t1}; quads[k++] = q2;
+                quadf_t q3 = {x + g->x0, y + g->y1, g->s0, g->t1}; quads[k++] = q3;
+            }
+            x += g->advance;
+        }
     }
-    dc->tex4(dc, c, &f->atlas, quads, n);
+    glyphs(dc, c, gc, page, quads, k / 4);
     return x;
 }
 
+static void sdf4(dc_t* dc, const colorf_t* color, font_t* f, quadf_t* quads, int count) {
+    // one atlas pixel distance is 127/255 / spread of texture value
+    const float smoothing = min(0.5f, 0.25f / (f->spread * f->scale));
+    use_program(shaders.sdf);
+    gl_check(glUniformMatrix4fv(shaders.sdf_mvp, 1, false, (GLfloat*)dc->mvp));
+    gl_check(glUniform4fv(shaders.sdf_rgba, 1, (GLfloat*)color));
+    gl_check(glUniform1f(shaders.sdf_smoothing, smoothing));
+    gl_check(glUniform1i(shaders.sdf_tex, 1)); // index(!) of GL_TEXTURE1 below
+    gl_check(glActiveTexture(GL_TEXTURE1));
+    font_t* b = f->base != null ? f->base : f;
+    gl_check(glBindTexture(GL_TEXTURE_2D, b->atlas.ti));
+    for (int i = 0; i < count; i++) {
+        gl_check(glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (GLfloat*)&quads[i * 4]));
+        gl_check(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
+    }
+}
+
+static int glyph_quads(font_t* b, float s, int ch, float* px, quadf_t* quads) {
+    // returns number of quadf_t written, characters outside of the atlas have no glyph
+    const unsigned int i = ch - b->from;
+    if (i >= (unsigned int)b->count) { return 0; }
+    stbtt_aligned_quad q;
+    float py = 0;
+    stbtt_GetPackedQuad((stbtt_packedchar*)b->chars, b->atlas.w, b->atlas.h, i, px, &py, &q, 0);
+    const float x0 = q.x0 * s;
+    const float y0 = q.y0 * s;
+    const float x1 = q.x1 * s;
+    const float y1 = q.y1 * s;
+    quadf_t q0 = {x0, y0, q.s0, q.t0}; quads[0] = q0;
+    quadf_t q1 = {x1, y0, q.s1, q.t0}; quads[1] = q1;
+    quadf_t q2 = {x1, y1, q.s1, q.t1}; quads[2] = q2;
+    quadf_t q3 = {x0, y1, q.s0, q.t1}; quads[3] = q3;
+    return 4;
+}
+
+static float layout(font_t* f, const char* text, int n, quadf_t* quads, int *count) {
+    // text is utf8 and n is number of bytes, quads are relative to origin
+    const float s = f->sdf ? f->scale : 1; // glyphs are positioned in atlas pixels and scaled
+    font_t* b = f->base != null ? f->base : f;
+    const bool kerning = b->kerning != null;
+    float px = 0;
+    int k = 0;
+    int prev = -1; // previous codepoint for kerning
+    const char* e = text + n;
+    while (text < e) {
+        const int ascii = utf8_ascii(text, e - text); // ASCII run does not need decoding
+        for (int i = 0; i < ascii; i++) {
+            const int ch = (byte)text[i];
+            if (kerning) { px += font_kerning(b, prev, ch); }
+            k += glyph_quads(b, s, ch, &px, &quads[k]);
+            prev = ch;
+        }
+        text += ascii;
+        if (text < e) {
+            int cp = 0;
+            text += utf8_decode(text, e, &cp);
+            if (kerning) { px += font_kerning(b, prev, cp); }
+            k += glyph_quads(b, s, cp, &px, &quads[k]);
+            prev = cp;
+        }
+    }
+    *count = k / 4;
+    return px * s;
+}
+
+static float text(dc_t* dc, const colorf_t* c, font_t* f, float x, float y, const char* text, int n) {
+    if (f->cache != null) { return text_cached(dc, c, f, x, y, text, n); }
+    quadf_t quads[n * 4]; // at most one glyph per byte
+    int count = 0;
+    float advance = 0;
+    const text_run_t* run = text_cache_find(f, text, n);
+    if (run == null) {
+        advance = layout(f, text, n, quads, &count);
+        run = text_cache_put(f, text, n, quads, count, advance);
+    }
+    if (run != null) {
+        count = run->count;
+        memcpy(quads, run->quads, count * 4 * sizeof(quadf_t));
+        advance = run->advance;
+    }
+    for (int i = 0; i < count * 4; i++) { quads[i].x += x; quads[i].y += y; }
+    if (f->sdf) {
+        sdf4(dc, c, f, quads, count);
+    } else {
+        dc->tex4(dc, c, &f->atlas, quads, count);
+    }
+    return x + advance;
+}
+
 static void orthographic_projection_2d(mat4x4 m, float x, float y, float w, float h) {
     const float znear = -1;
     const float zfar  =  1;
@@ -0,0 +1,164 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "face.h"
+#include "app.h"
+#include "font.h"
+#include "glyph_cache.h"
+#include "lz4.h"
+
+begin_c
+
+static face_t* faces; // registry
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void unmap(face_t* face) {
+    if (face->asset != null) { sys.asset_unmap(face->a, face->asset, face->data, face->bytes); }
+    deallocate(face->ttf);
+    deallocate(face);
+}
+
+static face_t* map(app_t* a, const char* name) { // called with mutex locked
+    face_t* face = null;
+    int r = strlen(name) < countof(face->name) ? 0 : ENAMETOOLONG;
+    if (r == 0) {
+        face = (face_t*)allocate(sizeof(face_t));
+        r = face == null ? ENOMEM : 0;
+    }
+    if (r == 0) {
+        strcpy(face->name, name);
+        face->a = a;
+        face->asset = sys.asset_map(a, name, &face->data, &face->bytes);
+        assertion(face->asset != null, "asset \"%s\" not found", name);
+        r = face->asset == null ? ENOENT : 0;
+    }
+    const void* ttf = face != null ? face->data : null;
+    if (r == 0 && lz4_is_compressed(name)) { // "*.ttf.lz4"
+        int decoded = 0;
+        r = lz4_decode_allocate(face->data, face->bytes, &face->ttf, &decoded);
+        assertion(r == 0, "failed to decompress \"%s\" %s", name, strerror(r));
+        ttf = face->ttf;
+    }
+    if (r == 0 && !stbtt_InitFont(&face->fi, ttf, 0)) {
+        r = EINVAL;
+    }
+    if (r == 0) {
+        face->refs = 1;
+    } else if (face != null) {
+        unmap(face);
+        face = null;
+    }
+    errno = r;
+    return face;
+}
+
+face_t* face_open(app_t* a, const char* name) {
+    pthread_mutex_lock(&mutex);
+    face_t* face = faces;
+    while (face != null && strcmp(face->name, name) != 0) { face = face->next; }
+    if (face != null) {
+        face->refs++;
+    } else {
+        face = map(a, name);
+        if (face != null) { face->next = faces; faces = face; }
+    }
+    pthread_mutex_unlock(&mutex);
+    return face;
+}
+
+void face_close(face_t* face) {
+    while (face != null) { // releases the fallback chain iteratively
+        face_t* fallback = null;
+        pthread_mutex_lock(&mutex);
+        assertion(face->refs > 0, "face \"%s\" already closed", face->name);
+        face->refs--;
+        if (face->refs == 0) {
+            face_t** p = &faces;
+            while (*p != face) { p = &(*p)->next; }
+            *p = face->next;
+            fallback = face->fallback;
+            unmap(face);
+        }
+        pthread_mutex_unlock(&mutex);
+        face = fallback;
+    }
+}
+
+int face_fallback(face_t* face, face_t* fallback) {
+    int r = 0;
+    pthread_mutex_lock(&mutex);
+    int n = 0; // length of the chain after the face
+    for (face_t* f = fallback; f != null && r == 0; f = f->fallback) {
+        if (f == face) { r = EINVAL; }
+        n++;
+    }
+    face_t* last = face;
+    while (last->fallback != null && r == 0) {
+        last = last->fallback;
+        n++;
+    }
+    if (r == 0 && n > GLYPH_CACHE_FALLBACKS) { r = ENOSPC; }
+    if (r == 0) {
+        fallback->refs++;
+        last->fallback = fallback;
+    }
+    pthread_mutex_unlock(&mutex);
+    return r;
+}
+
+font_t* face_font(face_t* face, int hpx) {
+    for (int i = 0; i < countof(face->fonts); i++) {
+        font_t* f = face->fonts[i];
+        if (f != null && f->height == hpx) { f->refs++; return f; }
+    }
+    int i = 0;
+    while (i < countof(face->fonts) && face->fonts[i] != null) { i++; }
+    int r = i < countof(face->fonts) ? 0 : ENOSPC;
+    font_t* f = null;
+    if (r == 0) {
+        f = (font_t*)allocate(sizeof(font_t));
+        r = f == null ? ENOMEM : 0;
+    }
+    if (r == 0) { r = font_load_asset_cached(f, face->a, face->name, hpx); }
+    if (r == 0) {
+        f->refs = 1;
+        face->fonts[i] = f;
+    } else {
+        deallocate(f);
+        f = null;
+    }
+    errno = r;
+    return f;
+}
+
+void face_font_release(font_t* f) {
+    assertion(f->refs > 0 && f->face != null, "not a face font or already released");
+    f->refs--;
+    if (f->refs == 0) {
+        face_t* face = f->face;
+        for (int i = 0; i < countof(face->fonts); i++) {
+            if (face->fonts[i] == f) { face->fonts[i] = null; }
+        }
+        font_dispose(f); // closes the face
+        deallocate(f);
+    }
+}
+
+void faces_deallocate() {
+    pthread_mutex_lock(&mutex);
+    for (face_t* face = faces; face != null; face = face->next) {
+        for (int i = 0; i < countof(face->fonts); i++) {
+            if (face->fonts[i] != null) { font_deallocate(face->fonts[i]); }
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+end_c
@@ -11,6 +11,12 @@
 #include "font.h"
 #include "app.h"
 #include "stb_rect_pack.h"
+#include "glyph_cache.h"
+#include "utf8.h"
+#include "text_cache.h"
+#include "tasks.h"
+#include "face.h"
+#include "raster.h"
 
 begin_c
 
@@ -19,10 +25,52 @@ static int32_t next_power_of_2(int32_t n) {
     return n + 1;
 }
 
-static int pack_font_to_texture(font_t* f, const void* ttf, stbtt_packedchar* chars, int hpx, int from, int count) {
+// Atlas is built in three steps: glyph boxes are gathered, rects are packed
+// (growing atlas until all fit, nothing is rasterized yet) and glyphs are
+// rasterized into their independent slots by tasks_parallel_for().
+
+typedef struct font_raster_s {
+    font_t* f;
+    stbtt_pack_context* pc;
+    stbtt_pack_range* range;
+    stbrp_rect* rects;
+    stbtt_packedchar* chars;
+} font_raster_t;
+
+static int rasterize_glyph(void* that, int i) {
+    // same placement and metrics as stbtt_PackFontRangesRenderIntoRects() without oversampling
+    font_raster_t* fr = (font_raster_t*)that;
+    font_t* f = fr->f;
+    stbrp_rect* rc = &fr->rects[i];
+    if (!rc->was_packed) { return ENOSPC; }
+    const stbtt_pack_context* pc = fr->pc;
+    const float scale = stbtt_ScaleForPixelHeight(&f->fi, fr->range->font_size);
+    const int glyph = stbtt_FindGlyphIndex(&f->fi, fr->range->first_unicode_codepoint_in_range + i);
+    const int x = rc->x + pc->padding; // pad on left and top
+    const int y = rc->y + pc->padding;
+    const int w = rc->w - pc->padding;
+    const int h = rc->h - pc->padding;
+    int advance = 0, lsb = 0;
+    stbtt_GetGlyphHMetrics(&f->fi, glyph, &advance, &lsb);
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    stbtt_GetGlyphBitmapBox(&f->fi, glyph, scale, scale, &x0, &y0, &x1, &y1);
+    stbtt_packedchar* bc = &fr->chars[i];
+    bc->x0 = (uint16_t)x;
+    bc->y0 = (uint16_t)y;
+    bc->x1 = (uint16_t)(x + w);
+    bc->y1 = (uint16_t)(y + h);
+    bc->xadvance = scale * advance;
+    bc->xoff  = (float)x0;
+    bc->yoff  = (float)y0;
+    bc->xoff2 = (float)(x0 + w);
+    bc->yoff2 = (float)(y0 + h);
+    return raster_glyph_bitmap(&f->fi, pc->pixels + x + y * pc->stride_in_bytes, w, h,
+                               pc->stride_in_bytes, scale, glyph);
+}
+
+static int pack_font_to_texture(font_t* f, stbtt_packedchar* chars, int hpx, int from, int count) {
     assert(hpx >= 2);
     assert(f->atlas.data == null);
-    int chars_bytes = sizeof(stbtt_packedchar) * count;
     int r = 0;
     const int np2 = next_power_of_2(hpx);
     // maximum number of bytes for hpx X hpx square cells
@@ -32,54 +80,205 @@ static int pack_font_to_texture(font_t* f, const void* ttf, stbtt_packedchar* ch
     f->atlas.w = next_power_of_2((int)sqrt(bytes_needed / 4));
     f->atlas.h = f->atlas.w / 2;
     f->atlas.comp = 1;
-    bool done = true;
-    do {
-        deallocate(f->atlas.data);
-        f->atlas.data = allocate(f->atlas.w * f->atlas.h); // 1 byte per pixel
-        if (f->atlas.data == null) {
-            r = errno;
-            done = true;
+    stbtt_pack_range range = {};
+    range.font_size = hpx;
+    range.first_unicode_codepoint_in_range = from;
+    range.num_chars = count;
+    range.chardata_for_range = chars;
+    stbrp_rect* rects = (stbrp_rect*)allocate(count * sizeof(stbrp_rect));
+    stbtt_pack_context pc = {};
+    bool done = false;
+    while (r == 0 && !done) {
+        if (rects == null || !stbtt_PackBegin(&pc, null, f->atlas.w, f->atlas.h, 0, 1, null)) {
+            r = ENOMEM;
         } else {
-            stbtt_pack_context pc = {};
-            memset(chars, 0, chars_bytes);
-            done = stbtt_PackBegin(&pc, f->atlas.data, f->atlas.w, f->atlas.h, 0, 1, null);
-            if (done) {
-                done = stbtt_PackFontRange(&pc, (void*)ttf, 0, hpx, from, count, chars);
-                stbtt_PackEnd(&pc);
+            const int n = stbtt_PackFontRangesGatherRects(&pc, &f->fi, &range, 1, rects);
+            stbtt_PackFontRangesPackRects(&pc, rects, n);
+            done = true;
+            for (int i = 0; i < n; i++) { done = done && rects[i].was_packed; }
+            stbtt_PackEnd(&pc);
+            if (!done) {
+                if (f->atlas.w * f->atlas.h <= bytes_needed) {
+                    if (f->atlas.w <= f->atlas.h) { f->atlas.w *= 2; } else { f->atlas.h *= 2; }
+                } else {
+                    r = ENOMEM;
+                }
             }
         }
-        if (!done) {
-            if (f->atlas.w * f->atlas.h <= bytes_needed) {
-                if (f->atlas.w <= f->atlas.h) { f->atlas.w *= 2; } else { f->atlas.h *= 2; }
-            } else {
-                r = ENOMEM;
-                done = true;
+    }
+    if (r == 0) {
+        f->atlas.data = allocate(f->atlas.w * f->atlas.h); // 1 byte per pixel
+        if (f->atlas.data == null) { r = ENOMEM; }
+    }
+    if (r == 0) {
+        pc.pixels = (byte*)f->atlas.data; // rasterizing needs only pixels, stride and padding
+        memset(chars, 0, count * sizeof(stbtt_packedchar));
+        font_raster_t fr = { f, &pc, &range, rects, chars };
+        r = tasks_parallel_for(count, rasterize_glyph, &fr);
+    }
+    deallocate(rects);
+    return r;
+}
+
+static int map_asset(font_t* f, app_t* a, const char* name) {
+    f->a = a;
+    f->face = face_open(a, name); // shared with other fonts of the same face
+    return f->face == null ? errno : 0;
+}
+
+static void unmap_asset(font_t* f) {
+    if (f->face != null) { face_close(f->face); }
+    if (f->asset != null) { sys.asset_unmap(f->a, f->asset, f->data, f->bytes); }
+    f->face = null;
+    f->asset = null;
+    f->data = null;
+    f->bytes = 0;
+}
+
+static float init_metrics(font_t* f, int hpx) { // returns scale
+    f->height = hpx;
+    f->fi = f->face->fi;
+    int ascent = 0;
+    int descent = 0;
+    int line_gap = 0;
+    float scale = stbtt_ScaleForPixelHeight(&f->fi, hpx);
+    stbtt_GetFontVMetrics(&f->fi, &ascent, &descent, &line_gap);
+    f->ascent = (int)(ascent * scale);
+    f->descent = (int)(descent * scale);
+    f->baseline = (int)(ascent * scale);
+    return scale;
+}
+
+// Text measurement tables are built once at load time: dense advances
+// and open addressing hash of non zero kerning pairs (ttf "kern" table).
+
+enum { FONT_KERNING_MAX_COUNT = 256 }; // count^2 pairs are queried on load
+
+static const uint16_t FONT_KERNING_EMPTY = 0xFFFF;
+
+static font_kerning_pair_t* kerning_slot(font_kerning_pair_t* pairs, int capacity, int left, int right) {
+    uint32_t i = (((uint32_t)left << 16) | right) * 2654435761U & (capacity - 1);
+    while (pairs[i].left != FONT_KERNING_EMPTY && (pairs[i].left != left || pairs[i].right != right)) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return &pairs[i];
+}
+
+static int init_kerning(font_t* f) {
+    if (f->fi.kern == 0 || f->count > FONT_KERNING_MAX_COUNT) { return 0; }
+    const int n = f->count;
+    int glyphs[n];
+    for (int i = 0; i < n; i++) { glyphs[i] = stbtt_FindGlyphIndex(&f->fi, f->from + i); }
+    const float scale = stbtt_ScaleForPixelHeight(&f->fi, f->height);
+    int pairs = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) { pairs += stbtt_GetGlyphKernAdvance(&f->fi, glyphs[i], glyphs[j]) != 0; }
+    }
+    if (pairs == 0) { return 0; }
+    const int capacity = next_power_of_2(pairs * 2);
+    f->kerning = (font_kerning_pair_t*)allocate(capacity * sizeof(font_kerning_pair_t));
+    if (f->kerning == null) { return ENOMEM; }
+    f->kerning_capacity = capacity;
+    for (int i = 0; i < capacity; i++) { f->kerning[i].left = FONT_KERNING_EMPTY; }
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            const int kern = stbtt_GetGlyphKernAdvance(&f->fi, glyphs[i], glyphs[j]);
+            if (kern != 0) {
+                font_kerning_pair_t* p = kerning_slot(f->kerning, capacity, i, j);
+                p->left = i;
+                p->right = j;
+                p->kern = kern * scale;
             }
         }
-    } while (!done);
-    return r;
+    }
+    return 0;
+}
+
+static int init_advances(font_t* f) {
+    f->advances = (float*)allocate(f->count * sizeof(float));
+    if (f->advances == null) { return ENOMEM; }
+    const stbtt_packedchar* chars = (const stbtt_packedchar*)f->chars;
+    bool monospace = f->kerning == null;
+    for (int i = 0; i < f->count; i++) {
+        f->advances[i] = chars[i].xadvance;
+        monospace = monospace && f->advances[i] == f->advances[0];
+    }
+    f->monospace = monospace ? f->advances[0] : 0;
+    f->em = font_text_width(f, "M", 1);
+    return 0;
+}
+
+static float pair_kerning(font_t* f, int left, int right) { // codepoints, 0 outside of the font range
+    const unsigned int l = left - f->from;
+    const unsigned int r = right - f->from;
+    return l < (unsigned int)f->count && r < (unsigned int)f->count ?
+           kerning_slot(f->kerning, f->kerning_capacity, l, r)->kern : 0;
+}
+
+static float kerning(font_t* f, const byte* s, int n) { // sum of kerning of subsequent pairs
+    float k = 0;
+    for (int i = 1; i < n; i++) { k += pair_kerning(f, s[i - 1], s[i]); }
+    return k;
+}
+
+static inline_c float advance(const float* advances, int from, int count, int ch) {
+    const unsigned int i = ch - from; // characters outside of the font range have no advance
+    return i < (unsigned int)count ? advances[i] : 0;
+}
+
+static float sum_advances(const float* advances, int from, int count, const byte* s, int n) {
+    // table lookups do not vectorize (NEON has no gather): 4 independent accumulators
+    float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += advance(advances, from, count, s[i + 0]);
+        s1 += advance(advances, from, count, s[i + 1]);
+        s2 += advance(advances, from, count, s[i + 2]);
+        s3 += advance(advances, from, count, s[i + 3]);
+    }
+    for (; i < n; i++) { s0 += advance(advances, from, count, s[i]); }
+    return (s0 + s1) + (s2 + s3);
+}
+
+static int in_range(int from, int count, const byte* s, int n) { // bytes in [from, from + count)
+    const int to = from + count < 256 ? from + count : 256;
+    if (from >= to) { return 0; }
+    if (to - from == 256) { return n; }
+    const byte b = (byte)from;
+    const byte w = (byte)(to - from); // (byte)(c - b) < w for c in range
+    int k = 0;
+    int i = 0;
+    #if defined(__SSE2__)
+    const __m128i vb = _mm_set1_epi8((char)b);
+    const __m128i vw = _mm_set1_epi8((char)(w - 1));
+    for (; i + 16 <= n; i += 16) {
+        const __m128i d = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(s + i)), vb);
+        k += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, vw), d)));
+    }
+    #elif defined(__aarch64__)
+    const uint8x16_t vb = vdupq_n_u8(b);
+    const uint8x16_t vw = vdupq_n_u8(w);
+    for (; i + 16 <= n; i += 16) {
+        k += vaddvq_u8(vshrq_n_u8(vcltq_u8(vsubq_u8(vld1q_u8(s + i), vb), vw), 7));
+    }
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint8x16_t vb = vdupq_n_u8(b);
+    const uint8x16_t vw = vdupq_n_u8(w);
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t ones = vshrq_n_u8(vcltq_u8(vsubq_u8(vld1q_u8(s + i), vb), vw), 7);
+        const uint64x2_t sum = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(ones)));
+        k += (int)(vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+    }
+    #endif
+    for (; i < n; i++) { k += (byte)(s[i] - b) < w; }
+    return k;
 }
 
 static int load_asset(font_t* f, app_t* a, const char* name, int hpx, int from, int count) {
-    int r = 0;
-    int bytes = 0;
-    const void* data = null;
-    void* asset = sys.asset_map(a, name, &data, &bytes);
-    assertion(asset != null, "asset \"%s\"not found", name);
-    if (asset == null) {
-        r = errno;
-    } else {
-        f->height = hpx;
-        stbtt_InitFont(&f->fi, data, 0);
-        int ascent = 0;
-        int descent = 0;
-        int line_gap = 0;
-        float scale = stbtt_ScaleForPixelHeight(&f->fi, hpx);
-        stbtt_GetFontVMetrics(&f->fi, &ascent, &descent, &line_gap);
+    int r = map_asset(f, a, name);
+    if (r == 0) {
+        init_metrics(f, hpx);
         if (count <= 0) { count = f->fi.numGlyphs; }
-        f->ascent = (int)(ascent * scale);
-        f->descent = (int)(descent * scale);
-        f->baseline = (int)(ascent * scale);
         f->from = from;
         f->count = count;
         int chars_bytes = sizeof(stbtt_packedchar) * count;
@@ -88,15 +287,205 @@ static int load_asset(font_t* f, app_t* a, const char* name, int hpx, int from,
             r = errno;
         } else {
             f->chars = chars;
-            r = pack_font_to_texture(f, data, chars, hpx, from, count);
-            if (r == 0) { f->em = font_text_width(f, "M", 1); }
+            r = pack_font_to_texture(f, chars, hpx, from, count);
+            if (r == 0) { r = init_kerning(f); }
+            if (r == 0) { r = init_advances(f); }
         }
-        sys.asset_unmap(a, asset, data, bytes);
     }
+    unmap_asset(f); // glyphs are already in the atlas
     if (r != 0) { font_dispose(f); }
     return r;
 }
 
+// Signed distance field glyphs: stb_truetype v1.11 has no SDF support thus
+// glyph is rasterized SDF_UPSCALE times larger, exact euclidean distance
+// transform (Felzenszwalb & Huttenlocher) is computed for inside and outside
+// pixels and sampled down at the centers of atlas pixels.
+
+enum {
+    SDF_UPSCALE = 4,
+    SDF_SPREAD  = 4 // atlas pixels
+};
+
+static const float SDF_FAR = 1e20f;
+
+static void edt1d(float* g, int n, int stride, float* f, float* z, int* v) {
+    for (int q = 0; q < n; q++) { f[q] = g[q * stride]; }
+    int k = 0;
+    v[0] = 0;
+    z[0] = -SDF_FAR;
+    z[1] = +SDF_FAR;
+    for (int q = 1; q < n; q++) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        while (s <= z[k]) {
+            k--;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = +SDF_FAR;
+    }
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q) { k++; }
+        g[q * stride] = (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+static void edt(float* g, int w, int h, float* f, float* z, int* v) { // squared distances
+    for (int x = 0; x < w; x++) { edt1d(g + x, h, w, f, z, v); }
+    for (int y = 0; y < h; y++) { edt1d(g + y * w, w, 1, f, z, v); }
+}
+
+static int sdf_glyph(font_t* f, int glyph, float scale, byte* out, int w, int h, int stride,
+                     int x0, int y0) {
+    // (x0, y0) glyph box top left corner at `scale' to align upscaled glyph
+    const int u = SDF_UPSCALE;
+    const int uw = w * u;
+    const int uh = h * u;
+    const int n = max(uw, uh);
+    byte*  coverage = (byte*)allocate(uw * uh);
+    float* inside   = (float*)allocate(uw * uh * sizeof(float));
+    float* outside  = (float*)allocate(uw * uh * sizeof(float));
+    float* ft = (float*)allocate(n * sizeof(float));
+    float* zt = (float*)allocate((n + 1) * sizeof(float));
+    int*   vt = (int*)allocate(n * sizeof(int));
+    int r = coverage == null || inside == null || outside == null ||
+            ft == null || zt == null || vt == null ? ENOMEM : 0;
+    if (r == 0) {
+        int ux0 = 0, uy0 = 0, ux1 = 0, uy1 = 0;
+        stbtt_GetGlyphBitmapBox(&f->fi, glyph, scale * u, scale * u, &ux0, &uy0, &ux1, &uy1);
+        const int dx = ux0 - (x0 - f->spread) * u;
+        const int dy = uy0 - (y0 - f->spread) * u;
+        const int gw = min(ux1 - ux0, uw - dx);
+        const int gh = min(uy1 - uy0, uh - dy);
+        r = raster_glyph_bitmap(&f->fi, coverage + dy * uw + dx, gw, gh, uw, scale * u, glyph);
+    }
+    if (r == 0) {
+        for (int i = 0; i < uw * uh; i++) {
+            const bool in = coverage[i] >= 128;
+            inside[i]  = in ? 0 : SDF_FAR; // distance to the nearest inside pixel
+            outside[i] = in ? SDF_FAR : 0;
+        }
+        edt(inside,  uw, uh, ft, zt, vt);
+        edt(outside, uw, uh, ft, zt, vt);
+        const float k = 127.0f / (f->spread * u);
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                const int i = (y * u + u / 2) * uw + x * u + u / 2;
+                const float d = sqrt(outside[i]) - sqrt(inside[i]); // positive inside
+                out[y * stride + x] = (byte)max(0, min(255, (int)(128 + d * k + 0.5f)));
+            }
+        }
+    }
+    deallocate(vt);
+    deallocate(zt);
+    deallocate(ft);
+    deallocate(outside);
+    deallocate(inside);
+    deallocate(coverage);
+    return r;
+}
+
+static int sdf_rasterize_glyph(void* that, int i) {
+    font_raster_t* fr = (font_raster_t*)that;
+    font_t* f = fr->f;
+    stbrp_rect* rects = fr->rects;
+    stbtt_packedchar* chars = fr->chars;
+    int r = 0;
+    const int glyph = stbtt_FindGlyphIndex(&f->fi, f->from + i);
+    const float scale = stbtt_ScaleForPixelHeight(&f->fi, f->height);
+    int advance = 0;
+    int lsb = 0;
+    stbtt_GetGlyphHMetrics(&f->fi, glyph, &advance, &lsb);
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    stbtt_GetGlyphBitmapBox(&f->fi, glyph, scale, scale, &x0, &y0, &x1, &y1);
+    stbtt_packedchar* pc = &chars[i];
+    const int w = rects[i].w - 1; // - padding
+    const int h = rects[i].h - 1;
+    pc->x0 = rects[i].x;
+    pc->y0 = rects[i].y;
+    pc->x1 = rects[i].x + w;
+    pc->y1 = rects[i].y + h;
+    pc->xoff = x0 - f->spread;
+    pc->yoff = y0 - f->spread;
+    pc->xoff2 = pc->xoff + w;
+    pc->yoff2 = pc->yoff + h;
+    pc->xadvance = advance * scale;
+    if (w > 0 && h > 0) {
+        byte* out = (byte*)f->atlas.data + rects[i].y * f->atlas.w + rects[i].x;
+        r = sdf_glyph(f, glyph, scale, out, w, h, f->atlas.w, x0, y0);
+    }
+    return r;
+}
+
+static int pack_sdf(font_t* f, stbtt_packedchar* chars, stbrp_rect* rects, int count) {
+    int r = 0;
+    const int n = count;
+    bool done = false;
+    const int np2 = next_power_of_2(f->height + 2 * f->spread);
+    f->atlas.w = next_power_of_2((int)sqrt(np2 * np2 * count / 2));
+    f->atlas.h = f->atlas.w / 2;
+    while (r == 0 && !done) {
+        stbrp_node* nodes = (stbrp_node*)allocate(f->atlas.w * sizeof(stbrp_node));
+        if (nodes == null) {
+            r = ENOMEM;
+        } else {
+            stbrp_context context = {};
+            stbrp_init_target(&context, f->atlas.w, f->atlas.h, nodes, f->atlas.w);
+            stbrp_pack_rects(&context, rects, n);
+            done = true;
+            for (int i = 0; i < n; i++) { done = done && rects[i].was_packed; }
+            if (!done) {
+                if (f->atlas.w <= f->atlas.h) { f->atlas.w *= 2; } else { f->atlas.h *= 2; }
+            }
+            deallocate(nodes);
+        }
+    }
+    if (r == 0) {
+        f->atlas.comp = 1;
+        f->atlas.data = allocate(f->atlas.w * f->atlas.h);
+        if (f->atlas.data == null) { r = ENOMEM; }
+    }
+    if (r == 0) {
+        font_raster_t fr = { f, null, null, rects, chars };
+        r = tasks_parallel_for(n, sdf_rasterize_glyph, &fr);
+    }
+    return r;
+}
+
+static int load_asset_sdf(font_t* f, app_t* a, const char* name, int hpx, int from, int count) {
+    int r = map_asset(f, a, name);
+    stbrp_rect* rects = null;
+    if (r == 0) {
+        const float scale = init_metrics(f, hpx);
+        f->from = from;
+        f->count = count;
+        f->sdf = true;
+        f->spread = SDF_SPREAD;
+        f->scale = 1;
+        f->chars = allocate(count * sizeof(stbtt_packedchar));
+        rects = (stbrp_rect*)allocate(count * sizeof(stbrp_rect));
+        r = f->chars == null || rects == null ? ENOMEM : 0;
+        for (int i = 0; i < count && r == 0; i++) {
+            int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+            const int glyph = stbtt_FindGlyphIndex(&f->fi, from + i);
+            stbtt_GetGlyphBitmapBox(&f->fi, glyph, scale, scale, &x0, &y0, &x1, &y1);
+            const bool empty = x1 <= x0 || y1 <= y0;
+            rects[i].id = i;
+            rects[i].w = (empty ? 0 : x1 - x0 + 2 * f->spread) + 1; // + 1 padding
+            rects[i].h = (empty ? 0 : y1 - y0 + 2 * f->spread) + 1;
+        }
+        if (r == 0) { r = pack_sdf(f, (stbtt_packedchar*)f->chars, rects, count); }
+        if (r == 0) { r = init_kerning(f); }
+        if (r == 0) { r = init_advances(f); }
+    }
+    deallocate(rects);
+    unmap_asset(f);
+    return r;
+}
+
 int font_load_asset(font_t* f, app_t* a, const char* name, int hpx, int from, int count) {
     assertion(f->atlas.data == null && f->chars == null && f->atlas.ti == 0,
              "bitmap already has data=%p chars=%p or texture=0x%08X or heigh in pixels too small %d",
@@ -115,6 +504,137 @@ int font_load_asset(font_t* f, app_t* a, const char* name, int hpx, int from, in
     return r;
 }
 
+int font_load_asset_cached(font_t* f, app_t* a, const char* name, int hpx) {
+    assertion(f->atlas.data == null && f->chars == null && f->cache == null,
+             "font already loaded data=%p chars=%p cache=%p", f->atlas.data, f->chars, f->cache);
+    int r = 0;
+    if (f->atlas.data != null || f->chars != null || f->cache != null || hpx < 3) {
+        r = EINVAL;
+    } else {
+        memset(f, 0, sizeof(*f));
+        r = map_asset(f, a, name);
+        if (r == 0) {
+            const float scale = init_metrics(f, hpx);
+            f->count = f->fi.numGlyphs;
+            f->cache = (glyph_cache_t*)allocate(sizeof(glyph_cache_t));
+            r = f->cache == null ? ENOMEM : glyph_cache_init(f->cache, &f->face->fi, scale);
+            for (face_t* fb = f->face->fallback; fb != null && r == 0; fb = fb->fallback) {
+                r = glyph_cache_fallback(f->cache, &fb->fi, stbtt_ScaleForPixelHeight(&fb->fi, hpx));
+            }
+        }
+        if (r == 0) { f->em = font_text_width(f, "M", 1); }
+        if (r != 0) { font_dispose(f); }
+    }
+    return r;
+}
+
+int font_load_asset_sdf(font_t* f, app_t* a, const char* name, int hpx, int from, int count) {
+    assertion(f->atlas.data == null && f->chars == null && f->atlas.ti == 0,
+             "font already loaded data=%p chars=%p texture=0x%08X", f->atlas.data, f->chars, f->atlas.ti);
+    assertion(hpx >= 8 && from > 0 && count > 0, "invalid paramerers hpx=%d from=%d count=%d", hpx, from, count);
+    int r = 0;
+    if (f->atlas.data != null || f->chars != null || f->atlas.ti != 0 || hpx < 8 || from <= 0 || count <= 0) {
+        r = EINVAL;
+    } else {
+        memset(f, 0, sizeof(*f));
+        r = load_asset_sdf(f, a, name, hpx, from, count);
+        if (r != 0) { font_dispose(f); }
+    }
+    return r;
+}
+
+static int load_baked(font_t* f) {
+    const font_baked_header_t* h = (const font_baked_header_t*)f->data;
+    const int header = sizeof(font_baked_header_t);
+    const int64_t chars = f->bytes < header ? 0 : (int64_t)h->count * sizeof(stbtt_packedchar);
+    const int64_t pixels = f->bytes < header ? 0 : (int64_t)h->w * h->h;
+    const int64_t pairs = f->bytes < header ? 0 : (int64_t)h->kerning * sizeof(font_kerning_pair_t);
+    int r = 0;
+    if (f->bytes < header || memcmp(h->magic, FONT_BAKED_MAGIC, sizeof(h->magic)) != 0 ||
+        h->count <= 0 || h->w <= 0 || h->h <= 0 || (h->kerning & (h->kerning - 1)) != 0 ||
+        header + chars + pairs + pixels != f->bytes) {
+        r = EINVAL;
+    } else {
+        f->height = h->height;
+        f->from = h->from;
+        f->count = h->count;
+        f->em = h->em;
+        f->ascent = h->ascent;
+        f->descent = h->descent;
+        f->baseline = h->baseline;
+        f->sdf = h->spread > 0;
+        f->spread = h->spread;
+        f->scale = 1;
+        f->baked = true;
+        f->chars = (byte*)f->data + header;
+        f->kerning = h->kerning > 0 ? (font_kerning_pair_t*)((byte*)f->data + header + chars) : null;
+        f->kerning_capacity = h->kerning;
+        f->atlas.w = h->w;
+        f->atlas.h = h->h;
+        f->atlas.comp = 1;
+        f->atlas.data = (byte*)f->data + header + chars + pairs; // uploaded straight from the mapped asset
+        r = init_advances(f);
+    }
+    return r;
+}
+
+int font_load_baked(font_t* f, app_t* a, const char* name) {
+    assertion(f->atlas.data == null && f->chars == null && f->atlas.ti == 0,
+             "font already loaded data=%p chars=%p texture=0x%08X", f->atlas.data, f->chars, f->atlas.ti);
+    int r = 0;
+    if (f->atlas.data != null || f->chars != null || f->atlas.ti != 0) {
+        r = EINVAL;
+    } else {
+        memset(f, 0, sizeof(*f));
+        f->a = a;
+        f->asset = sys.asset_map(a, name, &f->data, &f->bytes);
+        r = f->asset == null ? ENOENT : load_baked(f);
+        assertion(r == 0 || r == ENOENT, "invalid baked font \"%s\"", name);
+        if (r != 0) { font_dispose(f); }
+    }
+    return r;
+}
+
+int font_scaled(font_t* f, font_t* sdf, int hpx) {
+    assertion(sdf->sdf && sdf->base == null, "expected base sdf font");
+    int r = 0;
+    if (!sdf->sdf || sdf->base != null || hpx <= 0) {
+        r = EINVAL;
+    } else {
+        text_cache_remove(f); // f may be rescaled without font_dispose()
+        memset(f, 0, sizeof(*f));
+        const float s = hpx / (float)sdf->height;
+        f->from = sdf->from;
+        f->count = sdf->count;
+        f->height = hpx;
+        f->em = sdf->em * s;
+        f->ascent = sdf->ascent * s;
+        f->descent = sdf->descent * s;
+        f->baseline = sdf->baseline * s;
+        f->sdf = true;
+        f->spread = sdf->spread;
+        f->scale = s;
+        f->base = sdf;
+    }
+    return r;
+}
+
+int font_allocate(font_t* f) {
+    assertion(f->base == null, "scaled font uses base font atlas");
+    int r = 0;
+    // glyph cache pages are allocated and uploaded on demand by dc.text()
+    if (f->cache == null && f->base == null) {
+        r = texture_allocate_and_update(&f->atlas);
+        if (r == 0 && f->sdf) { r = texture_linear(&f->atlas); }
+    }
+    return r;
+}
+
+void font_deallocate(font_t* f) {
+    if (f->cache != null) { glyph_cache_deallocate(f->cache); }
+    if (f->atlas.ti != 0) { texture_deallocate(&f->atlas); }
+}
+
 int font_find_glyph_index(font_t* f, int unicode_codepoint) {
     int ix = stbtt_FindGlyphIndex(&f->fi, unicode_codepoint);
     if (ix != 0) {
@@ -127,9 +647,17 @@ int font_find_glyph_index(font_t* f, int unicode_codepoint) {
 }
 
 void font_dispose(font_t* f) {
+    text_cache_remove(f);
+    if (f->base != null) { memset(f, 0, sizeof(*f)); return; } // shares base font data
     assertion(f->atlas.ti == 0, "font_deallocate() must be called on hidden() before font_dispose()");
     // Plan B: just in case font_dispose() called while window is still not hidden()
-    if (f->atlas.ti != 0) { texture_deallocate(&f->atlas); }
+    if (f->atlas.ti != 0 || f->cache != null) { font_deallocate(f); }
+    if (f->cache != null) { glyph_cache_dispose(f->cache); }
+    deallocate(f->cache);
+    if (f->baked) { f->chars = null; f->kerning = null; f->atlas.data = null; } // unmapped below
+    unmap_asset(f);
+    deallocate(f->advances);
+    deallocate(f->kerning);
     deallocate(f->atlas.data);
     deallocate(f->chars);
     memset(f, 0, sizeof(*f));
@@ -137,16 +665,49 @@ void font_dispose(font_t* f) {
 
 float font_text_width(font_t* f, const char* text, int count) {
     if (count < 0) { count = strlen(text); }
+    if (f->cache != null) { // does not rasterize glyphs
+        float x = 0;
+        const char* e = text + count;
+        while (text < e) {
+            int cp = 0;
+            text += utf8_decode(text, e, &cp);
+            x += glyph_cache_advance(f->cache, cp);
+        }
+        return x;
+    }
+    const float scale = f->sdf ? f->scale : 1;
+    if (f->base != null) { f = f->base; }
+    const byte* s = (const byte*)text;
+    const byte* e = s + count;
     float x = 0;
-    float y = 0;
-    const int w = f->atlas.w;
-    const int h = f->atlas.h;
-    stbtt_packedchar* chars = (stbtt_packedchar*)f->chars;
-    for (int i = 0; i < count; i++) {
-        stbtt_aligned_quad q;
-        stbtt_GetPackedQuad(chars, w, h, text[i] - f->from, &x, &y, &q, 0);
-    }
-    return x;
+    int prev = -1; // previous codepoint for kerning
+    while (s < e) { // ASCII runs are summed in bulk, other codepoints decoded one by one
+        const int n = utf8_ascii((const char*)s, e - s);
+        if (n > 0 && f->monospace > 0) { // no kerning, all glyphs have the same advance
+            // bytes outside of the font range ('\n', '\r'...) advance by 0 as in sum_advances()
+            const bool all = f->from == 0 && f->count >= 0x80; // ASCII run is always in range
+            x += (all ? n : in_range(f->from, f->count, s, n)) * f->monospace;
+        } else if (n > 0) {
+            x += sum_advances(f->advances, f->from, f->count, s, n);
+            if (f->kerning != null) { x += pair_kerning(f, prev, s[0]) + kerning(f, s, n); }
+        }
+        if (n > 0) { prev = s[n - 1]; s += n; }
+        if (s < e) {
+            int cp = 0;
+            s += utf8_decode((const char*)s, (const char*)e, &cp);
+            x += advance(f->advances, f->from, f->count, cp);
+            if (f->kerning != null) { x += pair_kerning(f, prev, cp); }
+            prev = cp;
+        }
+    }
+    return x * scale;
+}
+
+float font_kerning(font_t* f, int left, int right) {
+    const float scale = f->sdf ? f->scale : 1;
+    if (f->base != null) { f = f->base; }
+    const float k = f->kerning != null ? pair_kerning(f, left, right) : 0;
+    return k * scale;
 }
 
 end_c
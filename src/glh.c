@@ -53,6 +53,15 @@ int gl_allocate(int *ti) {
     return r;
 }
 
+int gl_linear(int ti) {
+    int r = 0;
+    gl_if_no_error(r, glBindTexture(GL_TEXTURE_2D, ti));
+    gl_if_no_error(r, glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    gl_if_no_error(r, glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    gl_if_no_error(r, glBindTexture(GL_TEXTURE_2D, 0));
+    return r;
+}
+
 int gl_update(int ti, int w, int h, int bpp, const void* data) {
     int r = 0;
     int c = bpp - 1;
@@ -69,6 +78,22 @@ int gl_update(int ti, int w, int h, int bpp, const void* data) {
     return r;
 }
 
+int gl_update_sub(int ti, int x, int y, int w, int h, int bpp, const void* data) {
+    int r = 0;
+    int c = bpp - 1;
+    static const int formats[] = { GL_ALPHA, GL_LUMINANCE_ALPHA, GL_RGB, GL_RGBA };
+    assertion(0 <= c && c < countof(formats), "invalid number of byte per pixel components: %d", bpp);
+    if (0 <= c && c < countof(formats)) {
+        int format = formats[c];
+        gl_if_no_error(r, glBindTexture(GL_TEXTURE_2D, ti));
+        gl_if_no_error(r, glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, format, GL_UNSIGNED_BYTE, data));
+        gl_if_no_error(r, glBindTexture(GL_TEXTURE_2D, 0));
+    } else {
+        r = EINVAL;
+    }
+    return r;
+}
+
 int gl_delete_texture(int ti) {
     int r = 0;
     assertion(ti > 0, "texture was not allocated ti=%d", ti);
@@ -0,0 +1,233 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "glyph_cache.h"
+#include "raster.h"
+#include "rt.h"
+
+begin_c
+
+enum {
+    GLYPH_PADDING = 1,       // pixels between glyphs to avoid bleeding
+    GLYPH_CACHE_CAPACITY = 256 // initial hash table capacity
+};
+
+static uint32_t hash(int codepoint) { return (uint32_t)codepoint * 2654435761U; }
+
+static glyph_t* slot(glyph_t* glyphs, int capacity, int codepoint) {
+    uint32_t i = hash(codepoint) & (capacity - 1);
+    while (glyphs[i].codepoint != -1 && glyphs[i].codepoint != codepoint) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return &glyphs[i];
+}
+
+static int rehash(glyph_cache_t* c, int capacity, int evicted) { // drops glyphs from `evicted' page
+    glyph_t* glyphs = (glyph_t*)allocate(capacity * sizeof(glyph_t));
+    if (glyphs == null) { return ENOMEM; }
+    for (int i = 0; i < capacity; i++) { glyphs[i].codepoint = -1; }
+    int count = 0;
+    for (int i = 0; i < c->capacity; i++) {
+        glyph_t* g = &c->glyphs[i];
+        if (g->codepoint != -1 && (evicted < 0 || g->page != evicted)) {
+            *slot(glyphs, capacity, g->codepoint) = *g;
+            count++;
+        }
+    }
+    deallocate(c->glyphs);
+    c->glyphs = glyphs;
+    c->capacity = capacity;
+    c->count = count;
+    return 0;
+}
+
+int glyph_cache_init(glyph_cache_t* c, const stbtt_fontinfo* fi, float scale) {
+    memset(c, 0, sizeof(*c));
+    c->faces[0].fi = fi;
+    c->faces[0].scale = scale;
+    c->faces_count = 1;
+    return rehash(c, GLYPH_CACHE_CAPACITY, -1);
+}
+
+int glyph_cache_fallback(glyph_cache_t* c, const stbtt_fontinfo* fi, float scale) {
+    if (c->faces_count >= countof(c->faces)) { return ENOSPC; }
+    c->faces[c->faces_count].fi = fi;
+    c->faces[c->faces_count].scale = scale;
+    c->faces_count++;
+    return 0;
+}
+
+static const glyph_face_t* face_of(glyph_cache_t* c, int codepoint, int *index) {
+    // first face that has the glyph, primary face ".notdef" glyph 0 if none has
+    for (int i = 0; i < c->faces_count; i++) {
+        *index = stbtt_FindGlyphIndex(c->faces[i].fi, codepoint);
+        if (*index != 0) { return &c->faces[i]; }
+    }
+    *index = 0;
+    return &c->faces[0];
+}
+
+glyph_t* glyph_cache_find(glyph_cache_t* c, int codepoint) {
+    glyph_t* g = slot(c->glyphs, c->capacity, codepoint);
+    if (g->codepoint == -1) { return null; }
+    if (g->page >= 0) { c->pages[g->page].used = ++c->clock; }
+    return g;
+}
+
+float glyph_cache_advance(glyph_cache_t* c, int codepoint) {
+    glyph_t* g = slot(c->glyphs, c->capacity, codepoint);
+    if (g->codepoint == codepoint) { return g->advance; }
+    int index = 0;
+    const glyph_face_t* face = face_of(c, codepoint, &index);
+    int advance = 0;
+    int lsb = 0;
+    stbtt_GetGlyphHMetrics(face->fi, index, &advance, &lsb);
+    return advance * face->scale;
+}
+
+static void dirty(glyph_page_t* p, int y0, int y1) {
+    if (p->dirty_y0 == p->dirty_y1) {
+        p->dirty_y0 = y0;
+        p->dirty_y1 = y1;
+    } else {
+        p->dirty_y0 = min(p->dirty_y0, y0);
+        p->dirty_y1 = max(p->dirty_y1, y1);
+    }
+}
+
+static bool place(glyph_page_t* p, int w, int h, int *x, int *y) { // best fit shelf
+    glyph_shelf_t* best = null;
+    for (int i = 0; i < p->shelves_count; i++) {
+        glyph_shelf_t* s = &p->shelves[i];
+        if (s->h >= h && s->h <= h + h / 2 && s->x + w <= p->atlas.w) {
+            if (best == null || s->h < best->h) { best = s; }
+        }
+    }
+    if (best == null && p->shelves_count < GLYPH_CACHE_SHELVES && p->bottom + h <= p->atlas.h) {
+        best = &p->shelves[p->shelves_count++];
+        best->x = 0;
+        best->y = p->bottom;
+        best->h = h;
+        p->bottom += h;
+    }
+    if (best != null) {
+        *x = best->x;
+        *y = best->y;
+        best->x += w;
+    }
+    return best != null;
+}
+
+static int add_page(glyph_cache_t* c) { // returns page or -errno
+    glyph_page_t* p = &c->pages[c->pages_count];
+    memset(p, 0, sizeof(*p));
+    p->atlas.w = GLYPH_CACHE_PAGE_W;
+    p->atlas.h = GLYPH_CACHE_PAGE_H;
+    p->atlas.comp = 1;
+    p->atlas.data = allocate(p->atlas.w * p->atlas.h);
+    if (p->atlas.data == null) { return -ENOMEM; }
+    dirty(p, 0, p->atlas.h);
+    return c->pages_count++;
+}
+
+static int evict(glyph_cache_t* c) { // least recently used page, returns page or -errno
+    int lru = 0;
+    for (int i = 1; i < c->pages_count; i++) {
+        if (c->pages[i].used < c->pages[lru].used) { lru = i; }
+    }
+    int r = rehash(c, c->capacity, lru);
+    if (r != 0) { return -r; }
+    glyph_page_t* p = &c->pages[lru];
+    memset(p->atlas.data, 0, p->atlas.w * p->atlas.h);
+    p->shelves_count = 0;
+    p->bottom = 0;
+    dirty(p, 0, p->atlas.h);
+    c->evictions++;
+    return lru;
+}
+
+static int allocate_rect(glyph_cache_t* c, int w, int h, int *x, int *y) { // returns page or -errno
+    for (int i = 0; i < c->pages_count; i++) {
+        if (place(&c->pages[i], w, h, x, y)) { return i; }
+    }
+    int page = c->pages_count < GLYPH_CACHE_PAGES ? add_page(c) : evict(c);
+    if (page >= 0 && !place(&c->pages[page], w, h, x, y)) { page = -ENOSPC; }
+    return page;
+}
+
+glyph_t* glyph_cache_add(glyph_cache_t* c, int codepoint) {
+    assertion(glyph_cache_find(c, codepoint) == null, "codepoint U+%04X already cached", codepoint);
+    if ((c->count + 1) * 2 > c->capacity && rehash(c, c->capacity * 2, -1) != 0) { return null; }
+    int index = 0;
+    const glyph_face_t* face = face_of(c, codepoint, &index);
+    glyph_t g = { codepoint, -1 };
+    int advance = 0;
+    int lsb = 0;
+    stbtt_GetGlyphHMetrics(face->fi, index, &advance, &lsb);
+    g.advance = advance * face->scale;
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    stbtt_GetGlyphBitmapBox(face->fi, index, face->scale, face->scale, &x0, &y0, &x1, &y1);
+    const int w = x1 - x0;
+    const int h = y1 - y0;
+    if (w > 0 && h > 0) {
+        int x = 0;
+        int y = 0;
+        const int page = allocate_rect(c, w + GLYPH_PADDING, h + GLYPH_PADDING, &x, &y);
+        if (page < 0) {
+            traceln("glyph U+%04X %dx%d does not fit: %s", codepoint, w, h, strerror(-page));
+            if (page != -ENOSPC) { return null; }
+        } else {
+            glyph_page_t* p = &c->pages[page];
+            byte* pixels = (byte*)p->atlas.data + y * p->atlas.w + x;
+            raster_glyph_bitmap(face->fi, pixels, w, h, p->atlas.w, face->scale, index);
+            dirty(p, y, y + h);
+            p->used = ++c->clock;
+            g.page = page;
+            g.x0 = x0; g.y0 = y0;
+            g.x1 = x1; g.y1 = y1;
+            g.s0 = x / (float)p->atlas.w;
+            g.t0 = y / (float)p->atlas.h;
+            g.s1 = (x + w) / (float)p->atlas.w;
+            g.t1 = (y + h) / (float)p->atlas.h;
+        }
+    }
+    glyph_t* s = slot(c->glyphs, c->capacity, codepoint); // after possible eviction rehash
+    *s = g;
+    c->count++;
+    return s;
+}
+
+int glyph_cache_upload(glyph_cache_t* c, int page) {
+    int r = 0;
+    glyph_page_t* p = &c->pages[page];
+    if (p->atlas.ti == 0) {
+        r = texture_allocate_and_update(&p->atlas);
+    } else if (p->dirty_y0 < p->dirty_y1) {
+        r = texture_update_rows(&p->atlas, p->dirty_y0, p->dirty_y1 - p->dirty_y0);
+    }
+    if (r == 0) { p->dirty_y0 = p->dirty_y1 = 0; }
+    return r;
+}
+
+void glyph_cache_deallocate(glyph_cache_t* c) {
+    for (int i = 0; i < c->pages_count; i++) {
+        glyph_page_t* p = &c->pages[i];
+        if (p->atlas.ti != 0) { texture_deallocate(&p->atlas); }
+        dirty(p, 0, p->atlas.h); // whole page on next upload
+    }
+}
+
+void glyph_cache_dispose(glyph_cache_t* c) {
+    for (int i = 0; i < c->pages_count; i++) { texture_dispose(&c->pages[i].atlas); }
+    deallocate(c->glyphs);
+    memset(c, 0, sizeof(*c));
+}
+
+end_c
@@ -0,0 +1,215 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "layout.h"
+#include "app.h"
+
+begin_c
+
+static ui_t* layout_ui(layout_t* l) { // nearest ui of the node or its ancestors
+    while (l != null && l->u == null) { l = l->parent; }
+    return l != null ? l->u : null;
+}
+
+void layout_init(layout_t* l, int kind, ui_t* u) {
+    assert(LAYOUT_LEAF <= kind && kind <= LAYOUT_GRID);
+    assertion(kind != LAYOUT_LEAF || u != null, "leaf must have ui");
+    memset(l, 0, sizeof(*l));
+    l->kind = kind;
+    l->u = u;
+    l->columns = 1;
+    if (u != null) { l->w = u->w; l->h = u->h; }
+}
+
+void layout_invalidate(layout_t* l) {
+    // invalid node always has invalid ancestors, no need to go further up
+    while (l != null && (l->measured.valid || l->arranged.valid)) {
+        l->measured.valid = false;
+        l->arranged.valid = false;
+        l = l->parent;
+    }
+}
+
+void layout_invalidate_all(layout_t* l) {
+    l->measured.valid = false;
+    l->arranged.valid = false;
+    for (layout_t* c = l->children; c != null; c = c->next) { layout_invalidate_all(c); }
+}
+
+void layout_add(layout_t* l, layout_t* child) {
+    assert(child->parent == null && child->next == null);
+    ui_t* p = layout_ui(l);
+    assertion(child->u == null || p == null || child->u->parent == p,
+              "ui of the node must be a child of the nearest ancestor ui");
+    (void)p;
+    layout_t** last = &l->children;
+    while (*last != null) { last = &(*last)->next; }
+    *last = child;
+    child->parent = l;
+    layout_invalidate(l);
+}
+
+void layout_remove(layout_t* l, layout_t* child) {
+    assert(child->parent == l);
+    layout_t** p = &l->children;
+    while (*p != null && *p != child) { p = &(*p)->next; }
+    assertion(*p == child, "not a child");
+    if (*p == child) { *p = child->next; }
+    child->parent = null;
+    child->next = null;
+    layout_invalidate(l);
+}
+
+static void measure(layout_t* l) {
+    if (l->measured.valid) { return; }
+    float w = 0;
+    float h = 0;
+    int n = 0;
+    for (layout_t* c = l->children; c != null; c = c->next) {
+        measure(c);
+        switch (l->kind) {
+            case LAYOUT_ROW:    w += c->measured.w; h = max(h, c->measured.h); break;
+            case LAYOUT_COLUMN: h += c->measured.h; w = max(w, c->measured.w); break;
+            default: /* stack and grid */
+                w = max(w, c->measured.w); h = max(h, c->measured.h); break;
+        }
+        n++;
+    }
+    const float gaps = n > 1 ? l->gap * (n - 1) : 0;
+    if (l->kind == LAYOUT_LEAF) {
+        w = l->w;
+        h = l->h;
+        if (l->measure != null) { l->measure(l, &w, &h); }
+    } else if (l->kind == LAYOUT_ROW) {
+        w += gaps;
+    } else if (l->kind == LAYOUT_COLUMN) {
+        h += gaps;
+    } else if (l->kind == LAYOUT_GRID && n > 0) { // uniform cells of the largest child size
+        const int columns = min(max(l->columns, 1), n);
+        const int rows = (n + columns - 1) / columns;
+        w = w * columns + l->gap * (columns - 1);
+        h = h * rows + l->gap * (rows - 1);
+    }
+    if (l->kind != LAYOUT_LEAF) {
+        w += l->padding * 2;
+        h += l->padding * 2;
+    }
+    l->measured.w = w;
+    l->measured.h = h;
+    l->measured.valid = true;
+}
+
+static bool arrange(layout_t* l, float x, float y, float w, float h);
+
+// aligns node desired size in the cell horizontally (hor) and/or vertically (ver)
+static bool place(layout_t* c, float x, float y, float w, float h, bool hor, bool ver) {
+    const float cw = !hor || c->align == LAYOUT_FILL ? w : min(c->measured.w, w);
+    const float ch = !ver || c->align == LAYOUT_FILL ? h : min(c->measured.h, h);
+    if (c->align == LAYOUT_CENTER) {
+        x += (w - cw) / 2;
+        y += (h - ch) / 2;
+    } else if (c->align == LAYOUT_END) {
+        x += w - cw;
+        y += h - ch;
+    }
+    return arrange(c, x, y, cw, ch);
+}
+
+static bool arrange_line(layout_t* l, float x, float y, float w, float h, bool row) {
+    float weights = 0;
+    float extra = row ? w : h; // space left after desired sizes and gaps
+    for (layout_t* c = l->children; c != null; c = c->next) {
+        weights += c->weight;
+        extra -= (row ? c->measured.w : c->measured.h) + (c->next != null ? l->gap : 0);
+    }
+    bool changed = false;
+    for (layout_t* c = l->children; c != null; c = c->next) {
+        float size = row ? c->measured.w : c->measured.h;
+        if (extra > 0 && weights > 0) { size += extra * c->weight / weights; }
+        if (row) {
+            changed |= place(c, x, y, size, h, false, true);
+            x += size + l->gap;
+        } else {
+            changed |= place(c, x, y, w, size, true, false);
+            y += size + l->gap;
+        }
+    }
+    return changed;
+}
+
+static bool arrange_grid(layout_t* l, float x, float y, float w, float h) {
+    int n = 0;
+    for (layout_t* c = l->children; c != null; c = c->next) { n++; }
+    bool changed = false;
+    if (n > 0) {
+        const int columns = min(max(l->columns, 1), n);
+        const int rows = (n + columns - 1) / columns;
+        const float cw = max(0, (w - l->gap * (columns - 1)) / columns);
+        const float ch = max(0, (h - l->gap * (rows - 1)) / rows);
+        int i = 0;
+        for (layout_t* c = l->children; c != null; c = c->next) {
+            const float cx = x + (i % columns) * (cw + l->gap);
+            const float cy = y + (i / columns) * (ch + l->gap);
+            changed |= place(c, cx, cy, cw, ch, true, true);
+            i++;
+        }
+    }
+    return changed;
+}
+
+static bool arrange(layout_t* l, float x, float y, float w, float h) { // returns true if anything moved
+    w = max(0, w);
+    h = max(0, h);
+    if (l->arranged.valid && l->arranged.x == x && l->arranged.y == y &&
+        l->arranged.w == w && l->arranged.h == h) {
+        return false; // nothing changed in the subtree
+    }
+    bool changed = false;
+    ui_t* u = l->u;
+    if (u != null && (u->x != x || u->y != y || u->w != w || u->h != h)) {
+        ui.set_bounds(u, x, y, w, h);
+        changed = true;
+    }
+    // children of the node ui are relative to it
+    const float p = l->padding;
+    const float ix = (u != null ? 0 : x) + p;
+    const float iy = (u != null ? 0 : y) + p;
+    const float iw = max(0, w - p * 2);
+    const float ih = max(0, h - p * 2);
+    switch (l->kind) {
+        case LAYOUT_ROW:    changed |= arrange_line(l, ix, iy, iw, ih, true);  break;
+        case LAYOUT_COLUMN: changed |= arrange_line(l, ix, iy, iw, ih, false); break;
+        case LAYOUT_GRID:   changed |= arrange_grid(l, ix, iy, iw, ih); break;
+        case LAYOUT_STACK:
+            for (layout_t* c = l->children; c != null; c = c->next) {
+                changed |= place(c, ix, iy, iw, ih, true, true);
+            }
+            break;
+        default: break;
+    }
+    l->arranged.x = x;
+    l->arranged.y = y;
+    l->arranged.w = w;
+    l->arranged.h = h;
+    l->arranged.valid = true;
+    return changed;
+}
+
+void layout_arrange(layout_t* l, float x, float y, float w, float h) {
+    measure(l);
+    if (arrange(l, x, y, w, h)) {
+        // moved children stay inside of ui they are relative to: one invalidate covers
+        // both their previous and new bounds
+        ui_t* u = l->u != null ? l->u->parent : layout_ui(l);
+        ui.invalidate(u != null ? u : &app->root);
+    }
+}
+
+end_c
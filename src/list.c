@@ -0,0 +1,318 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "list.h"
+#include "app.h"
+
+begin_c
+
+static float list_row_height(list_t* l, int row) { // measured or estimated
+    return l->height != null && l->measured[row / LIST_BLOCK] ? l->height(l, row) : l->row_height;
+}
+
+static void list_tree_add(list_t* l, int b, double d) {
+    for (int i = b + 1; i <= l->blocks; i += i & -i) { l->tree[i] += d; }
+}
+
+static double list_tree_prefix(list_t* l, int b) { // height of blocks [0, b)
+    double y = 0;
+    for (int i = b; i > 0; i -= i & -i) { y += l->tree[i]; }
+    return y;
+}
+
+static void list_measure(list_t* l, int b) { // replaces estimated (or stale) height of the block
+    if (l->height != null && !l->measured[b]) {
+        const int first = b * LIST_BLOCK;
+        const int n = min(LIST_BLOCK, l->rows - first);
+        double h = 0;
+        for (int i = 0; i < n; i++) { h += l->height(l, first + i); }
+        list_tree_add(l, b, h - (list_tree_prefix(l, b + 1) - list_tree_prefix(l, b)));
+        l->measured[b] = true;
+    }
+}
+
+static double list_top(list_t* l, int row) { // of the row in content coordinates
+    if (l->height == null) { return (double)row * l->row_height; }
+    const int b = row / LIST_BLOCK;
+    double y = list_tree_prefix(l, b);
+    for (int r = b * LIST_BLOCK; r < row; r++) { y += list_row_height(l, r); }
+    return y;
+}
+
+static int list_row_at(list_t* l, double y) { // row containing y of the content
+    assert(l->rows > 0);
+    if (l->height == null) {
+        const int r = l->row_height > 0 ? (int)(max(0, y) / l->row_height) : 0;
+        return min(r, l->rows - 1);
+    }
+    int b = 0; // Fenwick tree descent: block containing y
+    int step = 1;
+    while (step * 2 <= l->blocks) { step *= 2; }
+    while (step > 0) {
+        if (b + step <= l->blocks && l->tree[b + step] <= y) {
+            b += step;
+            y -= l->tree[b];
+        }
+        step /= 2;
+    }
+    if (b >= l->blocks) { return l->rows - 1; }
+    int r = b * LIST_BLOCK;
+    const int end = min(l->rows, r + LIST_BLOCK);
+    while (r < end - 1) {
+        const float h = list_row_height(l, r);
+        if (y < h) { break; }
+        y -= h;
+        r++;
+    }
+    return r;
+}
+
+double list_content_height(list_t* l) {
+    return l->height == null ? (double)l->rows * l->row_height : list_tree_prefix(l, l->blocks);
+}
+
+static void list_clamp(list_t* l) {
+    const double bottom = max(0, list_content_height(l) - l->u.h);
+    l->offset = min(max(0, l->offset), bottom);
+}
+
+static bool list_reserve(void** p, int* capacity, int count, int size) { // capacity >= count
+    if (count <= *capacity) { return true; }
+    int n = *capacity == 0 ? 16 : *capacity;
+    while (n < count) { n *= 2; }
+    void* a = reallocate(*p, n * size);
+    if (a != null) { *p = a; *capacity = n; }
+    return a != null;
+}
+
+static int list_free_view(list_t* l, int f) { // first free view at or after f, allocates if none
+    while (f < l->views_count && l->items[f] >= 0) { f++; }
+    if (f == l->views_count) {
+        int capacity = l->views_capacity; // views and items grow together
+        ui_t* v = null;
+        if (list_reserve((void**)&l->views, &capacity, l->views_count + 1, sizeof(ui_t*)) &&
+            list_reserve((void**)&l->items, &l->views_capacity, l->views_count + 1, sizeof(int))) {
+            v = ui_store_allocate(&l->store, &l->u, l->u.that, 0, 0, 0, 0);
+        }
+        assertion(v != null, "out of memory");
+        if (v == null) { return -1; }
+        l->views[f] = v;
+        l->items[f] = -1;
+        l->views_count++;
+    }
+    return f;
+}
+
+static void list_update(list_t* l) { // binds and positions views of the rows in the list bounds
+    l->laid_w = l->u.w;
+    l->laid_h = l->u.h;
+    int first = 0;
+    int last = -1;
+    if (l->rows > 0 && l->u.h > 0) {
+        list_clamp(l);
+        const double content = list_content_height(l);
+        const bool at_bottom = l->offset > 0 && l->offset >= content - l->u.h;
+        int anchor = list_row_at(l, l->offset);
+        if (l->height != null) {
+            // measuring blocks above the anchor row would move it: keep it in place
+            const double dy = list_top(l, anchor) - l->offset;
+            list_measure(l, max(0, anchor - LIST_OVERSCAN) / LIST_BLOCK);
+            list_measure(l, anchor / LIST_BLOCK);
+            l->offset = list_top(l, anchor) - dy;
+            list_clamp(l);
+            anchor = list_row_at(l, l->offset);
+            list_measure(l, anchor / LIST_BLOCK);
+        }
+        first = max(0, anchor - LIST_OVERSCAN);
+        last = anchor;
+        double y = list_top(l, anchor) + list_row_height(l, anchor);
+        const double bottom = l->offset + l->u.h;
+        while (last < l->rows - 1 && y < bottom) {
+            last++;
+            if (last % LIST_BLOCK == 0) { list_measure(l, last / LIST_BLOCK); }
+            y += list_row_height(l, last);
+        }
+        for (int i = 0; i < LIST_OVERSCAN && last < l->rows - 1; i++) {
+            last++;
+            if (last % LIST_BLOCK == 0) { list_measure(l, last / LIST_BLOCK); }
+        }
+        if (at_bottom && list_content_height(l) != content) {
+            // last blocks were measured just now: stay at the bottom, blocks at the end are
+            // measured, next pass does not change content height
+            l->offset = list_content_height(l);
+            list_update(l);
+            return;
+        }
+    }
+    const int i0 = first * l->columns;
+    const int i1 = min(l->total, (last + 1) * l->columns);
+    const int n = max(0, i1 - i0);
+    if (!list_reserve((void**)&l->slots, &l->slots_capacity, n, sizeof(ui_t*))) { return; }
+    memset(l->slots, 0, n * sizeof(ui_t*));
+    for (int i = 0; i < l->views_count; i++) { // keep views of the items in range
+        const int item = l->items[i];
+        if (i0 <= item && item < i1) {
+            l->slots[item - i0] = l->views[i];
+        } else if (item >= 0) {
+            l->items[i] = -1;
+            ui.hide(l->views[i], true);
+        }
+    }
+    int f = 0;
+    for (int k = 0; k < n; k++) { // recycle free views for the items that have none
+        if (l->slots[k] == null) {
+            f = list_free_view(l, f);
+            if (f < 0) { break; }
+            l->items[f] = i0 + k;
+            l->bind(l, l->views[f], i0 + k);
+            l->slots[k] = l->views[f];
+        }
+    }
+    const float cw = l->u.w / l->columns;
+    double y = n > 0 ? list_top(l, first) - l->offset : 0;
+    for (int row = first; row <= last; row++) {
+        const float h = list_row_height(l, row);
+        for (int c = 0; c < l->columns; c++) {
+            const int k = row * l->columns + c - i0;
+            ui_t* v = k < n ? l->slots[k] : null;
+            if (v != null) {
+                ui.set_bounds(v, c * cw, (float)y, cw, h);
+                if (v->hidden) { ui.hide(v, false); }
+            }
+        }
+        y += h;
+    }
+}
+
+int list_reload(list_t* l) {
+    assertion(l->count != null && l->bind != null, "count() and bind() are required");
+    int r = 0;
+    l->total = max(0, l->count(l));
+    l->rows = (l->total + l->columns - 1) / l->columns;
+    l->blocks = l->height != null ? (l->rows + LIST_BLOCK - 1) / LIST_BLOCK : 0;
+    deallocate(l->tree);
+    deallocate(l->measured);
+    l->tree = null;
+    l->measured = null;
+    if (l->blocks > 0) {
+        l->tree = (double*)allocate((l->blocks + 1) * sizeof(double));
+        l->measured = (byte*)allocate(l->blocks);
+        if (l->tree == null || l->measured == null) { r = ENOMEM; }
+    }
+    if (r != 0) {
+        l->total = 0;
+        l->rows = 0;
+        l->blocks = 0;
+    }
+    for (int i = 1; i <= l->blocks; i++) { // linear build from estimated heights
+        const int n = min(LIST_BLOCK, l->rows - (i - 1) * LIST_BLOCK);
+        l->tree[i] += (double)n * l->row_height;
+        const int j = i + (i & -i);
+        if (j <= l->blocks) { l->tree[j] += l->tree[i]; }
+    }
+    for (int i = 0; i < l->views_count; i++) { l->items[i] = -1; } // rebind all
+    list_update(l);
+    ui.invalidate(&l->u);
+    return r;
+}
+
+void list_scroll(list_t* l, double offset) {
+    const double was = l->offset;
+    l->offset = offset;
+    list_update(l);
+    if (l->offset != was) { ui.invalidate(&l->u); }
+}
+
+void list_invalidate_row(list_t* l, int row) {
+    if (0 <= row && row < l->rows) {
+        if (l->height != null) { l->measured[row / LIST_BLOCK] = false; }
+        for (int i = 0; i < l->views_count; i++) {
+            if (l->items[i] >= 0 && l->items[i] / l->columns == row) { l->items[i] = -1; }
+        }
+        list_update(l);
+        ui.invalidate(&l->u);
+    }
+}
+
+static void list_draw(ui_t* u) {
+    list_t* l = (list_t*)u;
+    if (l->laid_w != u->w || l->laid_h != u->h) { list_update(l); }
+    const rectf_t r = ui.screen_rect(u);
+    const rectf_t k = dc.clipping; // of the frame, empty when not clipped
+    float x0 = r.x;
+    float y0 = r.y;
+    float x1 = r.x + r.w;
+    float y1 = r.y + r.h;
+    if (k.w > 0 && k.h > 0) {
+        x0 = max(x0, k.x);
+        y0 = max(y0, k.y);
+        x1 = min(x1, k.x + k.w);
+        y1 = min(y1, k.y + k.h);
+    }
+    if (x0 < x1 && y0 < y1) {
+        dc.clip(&dc, x0, y0, x1 - x0, y1 - y0); // views scrolled partially out are cut at the edges
+        if (l->background != null) { dc.fill(&dc, l->background, r.x, r.y, r.w, r.h); }
+        u->draw_children(u);
+        dc.clip(&dc, k.x, k.y, k.w, k.h); // restores frame clipping or turns it off
+    }
+}
+
+static bool list_touch(ui_t* u, int touch_action, float x, float y) {
+    // captured pointer: dragging continues when the finger leaves the list bounds
+    list_t* l = (list_t*)u;
+    const float sy = ui.screen_rect(u).y + y;
+    if (touch_action & TOUCH_DOWN) {
+        ui.capture(u);
+        l->pressed = true;
+        l->dragging = false;
+        l->drag_y = sy;
+    } else if ((touch_action & TOUCH_MOVE) && l->pressed) {
+        const float slop = (u->a->ydpi > 0 ? u->a->ydpi : 160) / 20; // 0.05 inch
+        if (!l->dragging && fabsf(sy - l->drag_y) >= slop) {
+            ui.capture(u); // exclusive: pressed views are disarmed
+            l->dragging = true;
+            l->drag_y = sy; // views do not jump by the slop
+        } else if (l->dragging) {
+            list_scroll(l, l->offset + l->drag_y - sy);
+            l->drag_y = sy;
+        }
+    } else if (touch_action & TOUCH_UP) {
+        l->pressed = false;
+        l->dragging = false;
+    }
+    if (touch_action & MOUSE_WHEEL) { // three rows per detent
+        list_scroll(l, l->offset - u->a->wheel_y * l->row_height * 3);
+    }
+    return (touch_action & (TOUCH_DOWN | MOUSE_WHEEL)) != 0 || l->dragging;
+}
+
+void list_init(list_t* l, ui_t* parent, void* that, float x, float y, float w, float h) {
+    assert((void*)l == (void*)&l->u);
+    memset(l, 0, sizeof(*l));
+    ui.init(&l->u, parent, that, x, y, w, h);
+    l->u.kind = UI_KIND_LIST;
+    l->u.draw = list_draw;
+    l->u.touch = list_touch;
+    l->columns = 1;
+    ui_store_init(&l->store, &l->u);
+}
+
+void list_done(list_t* l) {
+    ui_store_dispose(&l->store);
+    deallocate(l->views);
+    deallocate(l->items);
+    deallocate(l->slots);
+    deallocate(l->tree);
+    deallocate(l->measured);
+    ui.done(&l->u);
+    memset(l, 0, sizeof(*l));
+}
+
+end_c
@@ -0,0 +1,173 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "lz4.h"
+
+begin_c
+
+enum {
+    LZ4_MAGIC     = 0x184D2204,
+    LZ4_MIN_MATCH = 4
+};
+
+static uint32_t le32(const byte* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+// "start" is the beginning of the whole output: linked blocks may refer to
+// data decoded by previous blocks (up to 64KB back).
+
+static int decode_block(const byte* ip, int bytes, byte* start, byte* op, byte* end, int* decoded) {
+    const byte* ie = ip + bytes;
+    byte* o = op;
+    while (ip < ie) {
+        const int token = *ip++;
+        int literals = token >> 4;
+        if (literals == 15) {
+            int b = 0;
+            do {
+                if (ip >= ie) { return EINVAL; }
+                b = *ip++; literals += b;
+            } while (b == 255);
+        }
+        if (literals > ie - ip || literals > end - o) { return EINVAL; }
+        memcpy(o, ip, literals);
+        ip += literals;
+        o  += literals;
+        if (ip >= ie) { break; } // last sequence contains literals only
+        if (ie - ip < 2) { return EINVAL; }
+        const int offset = ip[0] | ip[1] << 8;
+        ip += 2;
+        if (offset == 0 || offset > o - start) { return EINVAL; }
+        int length = token & 0xF;
+        if (length == 15) {
+            int b = 0;
+            do {
+                if (ip >= ie) { return EINVAL; }
+                b = *ip++; length += b;
+            } while (b == 255);
+        }
+        length += LZ4_MIN_MATCH;
+        if (length > end - o) { return EINVAL; }
+        const byte* m = o - offset;
+        if (offset >= length) {
+            memcpy(o, m, length);
+            o += length;
+        } else { // overlapping match repeats last `offset' bytes
+            for (int i = 0; i < length; i++) { *o++ = *m++; }
+        }
+    }
+    *decoded = (int)(o - op);
+    return 0;
+}
+
+int lz4_stream_init(lz4_stream_t* s, const void* data, int bytes) {
+    static const int block_max[] = { 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+    memset(s, 0, sizeof(*s));
+    const byte* p = (const byte*)data;
+    if (bytes < 7 || le32(p) != LZ4_MAGIC) { return EINVAL; }
+    const int flg = p[4];
+    const int bd  = p[5];
+    if ((flg >> 6) != 1) { return ENOTSUP; } // version must be 01
+    if (flg & 0x1) { return ENOTSUP; }       // dictionaries are not supported
+    const int bsid = (bd >> 4) & 0x7;
+    if (bsid < 4) { return EINVAL; }
+    int header = 7; // magic + FLG + BD + HC
+    s->content_size = -1;
+    if (flg & 0x8) {
+        if (bytes < header + 8) { return EINVAL; }
+        s->content_size = (int64_t)le32(p + 6) | (int64_t)le32(p + 10) << 32;
+        header += 8;
+    }
+    s->data = p;
+    s->bytes = bytes;
+    s->position = header;
+    s->block_max = block_max[bsid - 4];
+    s->block_checksum = (flg & 0x10) != 0;
+    s->content_checksum = (flg & 0x4) != 0;
+    return 0;
+}
+
+int lz4_stream_output(lz4_stream_t* s, void* output, int capacity) {
+    assertion(s->data != null, "lz4_stream_init() must be called first");
+    if (s->content_size > capacity) { return ENOMEM; }
+    s->output = (byte*)output;
+    s->capacity = capacity;
+    s->decoded = 0;
+    return 0;
+}
+
+int lz4_stream_next(lz4_stream_t* s) {
+    assertion(s->output != null, "lz4_stream_output() must be called first");
+    if (s->bytes - s->position < 4) { return EINVAL; }
+    const uint32_t size = le32(s->data + s->position);
+    s->position += 4;
+    if (size == 0) { // EndMark
+        s->position += s->content_checksum ? 4 : 0;
+        return ENODATA;
+    }
+    const bool uncompressed = (size & 0x80000000U) != 0;
+    const int n = (int)(size & 0x7FFFFFFFU);
+    if (n > s->block_max || n > s->bytes - s->position) { return EINVAL; }
+    const byte* block = s->data + s->position;
+    byte* op = s->output + s->decoded;
+    int r = 0;
+    int decoded = 0;
+    if (uncompressed) {
+        if (n > s->capacity - s->decoded) {
+            r = ENOMEM;
+        } else {
+            memcpy(op, block, n);
+            decoded = n;
+        }
+    } else {
+        r = decode_block(block, n, s->output, op, s->output + s->capacity, &decoded);
+    }
+    if (r == 0) {
+        s->decoded += decoded;
+        s->position += n + (s->block_checksum ? 4 : 0);
+    }
+    return r;
+}
+
+int lz4_decode(const void* data, int bytes, void* output, int capacity, int *decoded) {
+    lz4_stream_t s;
+    *decoded = 0;
+    int r = lz4_stream_init(&s, data, bytes);
+    if (r == 0) { r = lz4_stream_output(&s, output, capacity); }
+    while (r == 0) { r = lz4_stream_next(&s); }
+    if (r == ENODATA) {
+        r = s.content_size >= 0 && s.content_size != s.decoded ? EINVAL : 0;
+    }
+    if (r == 0) { *decoded = s.decoded; }
+    return r;
+}
+
+int lz4_decode_allocate(const void* data, int bytes, void* *output, int *decoded) {
+    lz4_stream_t s;
+    *output = null;
+    *decoded = 0;
+    int r = lz4_stream_init(&s, data, bytes);
+    assertion(r != 0 || s.content_size >= 0, "compress with: lz4 --content-size");
+    if (r == 0 && (s.content_size < 0 || s.content_size > INT32_MAX)) { r = ENOTSUP; }
+    void* p = r == 0 ? allocate((size_t)s.content_size + 1) : null; // +1 for empty content
+    if (r == 0 && p == null) { r = ENOMEM; }
+    if (r == 0) { r = lz4_decode(data, bytes, p, (int)s.content_size, decoded); }
+    if (r == 0) { *output = p; } else { deallocate(p); }
+    return r;
+}
+
+bool lz4_is_compressed(const char* name) {
+    const int n = (int)strlen(name);
+    return n > 4 && strcmp(name + n - 4, ".lz4") == 0;
+}
+
+end_c
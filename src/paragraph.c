@@ -0,0 +1,135 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "paragraph.h"
+#include "font.h"
+#include "utf8.h"
+
+begin_c
+
+static bool is_space(char ch) { return ch == ' ' || ch == '\t'; }
+
+static void measure(paragraph_t* p) { // x of every byte, continuation bytes share x of the codepoint
+    font_t* f = p->font;
+    const char* s = p->text;
+    float x = 0;
+    int prev = -1; // previous codepoint for kerning
+    int i = 0;
+    while (i < p->bytes) {
+        int cp = 0;
+        const int n = utf8_decode(s + i, s + p->bytes, &cp);
+        if (cp == '\n') {
+            prev = -1;
+        } else {
+            if (prev >= 0) { x += font_kerning(f, prev, cp); }
+            prev = cp;
+        }
+        for (int k = 0; k < n; k++) { p->x[i + k] = x; }
+        if (cp != '\n') { x += font_text_width(f, s + i, n); }
+        i += n;
+    }
+    p->x[p->bytes] = x;
+}
+
+static int add_line(paragraph_t* p, int start, int end) { // trailing spaces are trimmed
+    if (p->count == p->lines_capacity) {
+        const int capacity = p->lines_capacity * 2 + 4;
+        void* lines = reallocate(p->lines, capacity * sizeof(paragraph_line_t));
+        if (lines == null) { return ENOMEM; }
+        p->lines = (paragraph_line_t*)lines;
+        p->lines_capacity = capacity;
+    }
+    while (end > start && is_space(p->text[end - 1])) { end--; }
+    paragraph_line_t* line = &p->lines[p->count++];
+    line->start = start;
+    line->bytes = end - start;
+    line->width = p->x[end] - p->x[start];
+    p->w = max(p->w, line->width);
+    return 0;
+}
+
+static int next(paragraph_t* p, int i) { // offset of the next codepoint
+    int cp = 0;
+    return i + utf8_decode(p->text + i, p->text + p->bytes, &cp);
+}
+
+static int wrap(paragraph_t* p) { // breaks lines to fit p->width
+    const char* s = p->text;
+    p->count = 0;
+    p->w = 0;
+    int r = 0;
+    int start = 0;
+    int i = 0;
+    int last = -1; // last break opportunity: start of a word after spaces
+    while (r == 0 && i < p->bytes) {
+        if (s[i] == '\n') {
+            r = add_line(p, start, i);
+            start = i + 1;
+            i = start;
+            last = -1;
+        } else if (is_space(s[i])) {
+            i++;
+            if (i < p->bytes && !is_space(s[i])) { last = i; }
+        } else {
+            const int n = next(p, i);
+            if (p->width > 0 && i > start && p->x[n] - p->x[start] > p->width) {
+                const int end = last > start ? last : i; // word does not fit: break at codepoint
+                r = add_line(p, start, end);
+                start = end;
+                i = end;
+                last = -1;
+            } else {
+                i = n;
+            }
+        }
+    }
+    if (r == 0) { r = add_line(p, start, p->bytes); }
+    p->h = p->count * p->height;
+    return r;
+}
+
+int paragraph_layout(paragraph_t* p, font_t* f, const char* text, int bytes, float width) {
+    if (bytes < 0) { bytes = (int)strlen(text); }
+    int r = 0;
+    const bool same_text = p->text != null && p->font == f && p->height == f->height &&
+                           p->bytes == bytes && memcmp(p->text, text, bytes) == 0;
+    if (!same_text) {
+        if (bytes + 1 > p->capacity) {
+            const int capacity = bytes + 1;
+            char* t = (char*)reallocate(p->text, capacity);
+            if (t != null) { p->text = t; }
+            float* x = (float*)reallocate(p->x, capacity * sizeof(float));
+            if (x != null) { p->x = x; }
+            if (t == null || x == null) { return ENOMEM; }
+            p->capacity = capacity;
+        }
+        memcpy(p->text, text, bytes);
+        p->text[bytes] = 0;
+        p->bytes = bytes;
+        p->font = f;
+        p->height = f->height;
+        measure(p);
+    }
+    if (!same_text || p->width != width || p->count == 0) {
+        p->width = width;
+        r = wrap(p);
+        if (r != 0) { p->count = 0; }
+    }
+    return r;
+}
+
+void paragraph_dispose(paragraph_t* p) {
+    deallocate(p->lines);
+    deallocate(p->x);
+    deallocate(p->text);
+    memset(p, 0, sizeof(*p));
+}
+
+end_c
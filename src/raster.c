@@ -0,0 +1,206 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "raster.h"
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+begin_c
+
+static const float RASTER_FLATNESS = 0.35f; // pixels
+
+int raster_mode = RASTER_ACCUMULATE;
+
+typedef struct raster_s {
+    float* a; // [w * h + 4] signed area, segments may touch one cell past the row end
+    int w;
+    int h;
+    float x; // pen position
+    float y;
+    float x0; // start of the contour
+    float y0;
+} raster_t;
+
+static void line(raster_t* r, float px0, float py0, float px1, float py1) {
+    if (fabsf(py0 - py1) <= 1e-6f) { return; } // horizontal lines do not add area
+    const float dir = py0 < py1 ? 1 : -1;
+    if (py0 > py1) {
+        float t = px0; px0 = px1; px1 = t;
+        t = py0; py0 = py1; py1 = t;
+    }
+    const float dxdy = (px1 - px0) / (py1 - py0);
+    float x = px0;
+    if (py0 < 0) { x -= py0 * dxdy; }
+    const int ye = min(r->h, (int)ceilf(py1));
+    for (int y = max(0, (int)py0); y < ye; y++) {
+        float* row = r->a + y * r->w;
+        const float dy = min((float)(y + 1), py1) - max((float)y, py0);
+        const float xnext = x + dxdy * dy;
+        const float d = dy * dir;
+        const float x0 = min(x, xnext);
+        const float x1 = max(x, xnext);
+        const float x0floor = floorf(x0);
+        const int x0i = (int)x0floor;
+        const float x1ceil = ceilf(x1);
+        const int x1i = (int)x1ceil;
+        if (x1i <= x0i + 1) { // within one cell
+            const float xmf = 0.5f * (x + xnext) - x0floor;
+            row[x0i] += d - d * xmf;
+            row[x0i + 1] += d * xmf;
+        } else {
+            const float s = 1 / (x1 - x0);
+            const float x0f = x0 - x0floor;
+            const float a0 = 0.5f * s * (1 - x0f) * (1 - x0f);
+            const float x1f = x1 - x1ceil + 1;
+            const float am = 0.5f * s * x1f * x1f;
+            row[x0i] += d * a0;
+            if (x1i == x0i + 2) {
+                row[x0i + 1] += d * (1 - a0 - am);
+            } else {
+                const float a1 = s * (1.5f - x0f);
+                row[x0i + 1] += d * (a1 - a0);
+                for (int xi = x0i + 2; xi < x1i - 1; xi++) { row[xi] += d * s; }
+                const float a2 = a1 + (x1i - x0i - 3) * s;
+                row[x1i - 1] += d * (1 - a2 - am);
+            }
+            row[x1i] += d * am;
+        }
+        x = xnext;
+    }
+}
+
+static void line_to(raster_t* r, float x, float y) {
+    x = max(0, min(x, (float)r->w)); // outline is inside the box up to rounding errors
+    y = max(0, min(y, (float)r->h));
+    line(r, r->x, r->y, x, y);
+    r->x = x;
+    r->y = y;
+}
+
+static void curve(raster_t* r, float x0, float y0, float x1, float y1, float x2, float y2, int n) {
+    // recursive midpoint subdivision with the same 0.35 pixel flatness as stbtt_MakeGlyphBitmap()
+    const float mx = (x0 + 2 * x1 + x2) / 4;
+    const float my = (y0 + 2 * y1 + y2) / 4;
+    const float dx = (x0 + x2) / 2 - mx;
+    const float dy = (y0 + y2) / 2 - my;
+    if (n <= 16 && dx * dx + dy * dy > RASTER_FLATNESS * RASTER_FLATNESS) {
+        curve(r, x0, y0, (x0 + x1) / 2, (y0 + y1) / 2, mx, my, n + 1);
+        curve(r, mx, my, (x1 + x2) / 2, (y1 + y2) / 2, x2, y2, n + 1);
+    } else {
+        line_to(r, x2, y2);
+    }
+}
+
+static void curve_to(raster_t* r, float cx, float cy, float x, float y) { // quadratic bezier
+    curve(r, r->x, r->y, cx, cy, x, y, 0);
+}
+
+static void accumulate(const float* a, byte* out, int w, int h, int stride) {
+    float sum = 0; // running over the whole buffer: areas spilled past row end carry into next row
+    for (int y = 0; y < h; y++) {
+        const float* row = a + y * w;
+        byte* o = out + y * stride;
+        int x = 0;
+        #if defined(__SSE2__)
+        const __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)); // fabs()
+        const __m128 one = _mm_set1_ps(1);
+        const __m128 k = _mm_set1_ps(255);
+        const __m128 half = _mm_set1_ps(0.5f);
+        __m128 carry = _mm_set1_ps(sum);
+        for (; x + 4 <= w; x += 4) {
+            __m128 v = _mm_loadu_ps(row + x); // prefix sum of 4 lanes in two shifted adds
+            v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+            v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+            v = _mm_add_ps(v, carry);
+            carry = _mm_shuffle_ps(v, v, 0xFF);
+            const __m128 c = _mm_min_ps(_mm_and_ps(v, mask), one);
+            __m128i q = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, k), half));
+            q = _mm_packs_epi32(q, q);
+            q = _mm_packus_epi16(q, q);
+            const uint32_t b4 = (uint32_t)_mm_cvtsi128_si32(q);
+            memcpy(o + x, &b4, sizeof(b4));
+        }
+        sum = _mm_cvtss_f32(carry);
+        #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        const float32x4_t zero = vdupq_n_f32(0);
+        const float32x4_t one = vdupq_n_f32(1);
+        const float32x4_t k = vdupq_n_f32(255);
+        const float32x4_t half = vdupq_n_f32(0.5f);
+        float32x4_t carry = vdupq_n_f32(sum);
+        for (; x + 4 <= w; x += 4) {
+            float32x4_t v = vld1q_f32(row + x);
+            v = vaddq_f32(v, vextq_f32(zero, v, 3)); // [0, v0, v1, v2]
+            v = vaddq_f32(v, vextq_f32(zero, v, 2)); // [0, 0, v0, v1]
+            v = vaddq_f32(v, carry);
+            carry = vdupq_n_f32(vgetq_lane_f32(v, 3));
+            const float32x4_t c = vminq_f32(vabsq_f32(v), one);
+            const uint16x4_t q = vmovn_u32(vcvtq_u32_f32(vmlaq_f32(half, c, k)));
+            const uint8x8_t b = vmovn_u16(vcombine_u16(q, q));
+            const uint32_t b4 = vget_lane_u32(vreinterpret_u32_u8(b), 0);
+            memcpy(o + x, &b4, sizeof(b4));
+        }
+        sum = vgetq_lane_f32(carry, 0);
+        #endif
+        for (; x < w; x++) {
+            sum += row[x];
+            o[x] = (byte)(min(fabsf(sum), 1.0f) * 255 + 0.5f);
+        }
+    }
+}
+
+int raster_glyph(const stbtt_fontinfo* fi, byte* out, int w, int h, int stride, float scale, int glyph) {
+    if (w <= 0 || h <= 0) { return 0; }
+    stbtt_vertex* v = null;
+    const int n = stbtt_GetGlyphShape(fi, glyph, &v);
+    int ix0 = 0, iy0 = 0, ix1 = 0, iy1 = 0;
+    stbtt_GetGlyphBitmapBox(fi, glyph, scale, scale, &ix0, &iy0, &ix1, &iy1);
+    raster_t r = {};
+    r.w = w;
+    r.h = h;
+    r.a = (float*)allocate((w * h + 4) * sizeof(float));
+    if (r.a == null) { stbtt_FreeShape(fi, v); return ENOMEM; }
+    // font units to pixels: y axis goes down in the bitmap
+    #define px(vx) ((vx) * scale - ix0)
+    #define py(vy) (-(vy) * scale - iy0)
+    for (int i = 0; i < n; i++) {
+        const stbtt_vertex* p = &v[i];
+        if (p->type == STBTT_vmove) {
+            if (r.x != r.x0 || r.y != r.y0) { line_to(&r, r.x0, r.y0); } // close contour
+            r.x = r.x0 = max(0, min(px(p->x), (float)w));
+            r.y = r.y0 = max(0, min(py(p->y), (float)h));
+        } else if (p->type == STBTT_vline) {
+            line_to(&r, px(p->x), py(p->y));
+        } else if (p->type == STBTT_vcurve) {
+            curve_to(&r, px(p->cx), py(p->cy), px(p->x), py(p->y));
+        }
+    }
+    if (r.x != r.x0 || r.y != r.y0) { line_to(&r, r.x0, r.y0); }
+    #undef px
+    #undef py
+    accumulate(r.a, out, w, h, stride);
+    deallocate(r.a);
+    stbtt_FreeShape(fi, v);
+    return 0;
+}
+
+int raster_glyph_bitmap(const stbtt_fontinfo* fi, byte* out, int w, int h, int stride, float scale, int glyph) {
+    int r = 0;
+    if (raster_mode == RASTER_ACCUMULATE) {
+        r = raster_glyph(fi, out, w, h, stride, scale, glyph);
+    } else {
+        stbtt_MakeGlyphBitmap(fi, out, w, h, stride, scale, scale, glyph);
+    }
+    return r;
+}
+
+end_c
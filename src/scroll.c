@@ -0,0 +1,271 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "scroll.h"
+#include "app.h"
+
+begin_c
+
+// distances are in inches of the screen, times in seconds:
+static const float scroll_slop         = 0.05f;  // finger travel before dragging starts
+static const float scroll_min_velocity = 0.25f;  // per second, slower fling comes to rest
+static const float scroll_max_velocity = 25.0f;  // per second
+static const float scroll_window       = 0.1f;   // of touch samples used for velocity estimate
+static const float scroll_friction     = 0.325f; // time constant of fling velocity decay
+static const float scroll_spring       = 0.1f;   // time constant of critically damped spring back
+static const float scroll_step         = 1 / 240.0f; // physics integration step
+
+static float scroll_inch(void) { return app->ydpi > 0 ? app->ydpi : 160; }
+
+static pointf_t scroll_range(scroll_t* s) { // maximum offset, 0 for axis that does not scroll
+    return (pointf_t){ max(0, s->content.w - s->u.w), max(0, s->content.h - s->u.h) };
+}
+
+static bool scroll_inside(scroll_t* s) {
+    const pointf_t range = scroll_range(s);
+    return 0 <= s->offset.x && s->offset.x <= range.x && 0 <= s->offset.y && s->offset.y <= range.y;
+}
+
+static void scroll_moved(scroll_t* s) { // content is kept on whole pixels
+    const float x = roundf(s->offset.x);
+    const float y = roundf(s->offset.y);
+    if (s->u.offset.x != x || s->u.offset.y != y) {
+        ui.scroll(&s->u, x, y); // translation only: content bounds and spatial index stay
+        ui.invalidate(&s->u);
+    }
+}
+
+static void scroll_clamp(scroll_t* s) {
+    const pointf_t range = scroll_range(s);
+    s->offset.x = min(max(0, s->offset.x), range.x);
+    s->offset.y = min(max(0, s->offset.y), range.y);
+    scroll_moved(s);
+}
+
+static void scroll_stop(scroll_t* s) {
+    animation_stop(&s->motion);
+    s->velocity = (pointf_t){0, 0};
+}
+
+static bool scroll_axis(float* offset, float* velocity, float range, float dt) { // true while moving
+    float o = *offset;
+    float v = *velocity;
+    const int n = (int)ceilf(dt / scroll_step); // substeps keep the spring stable on long frames
+    const float h = n > 0 ? dt / n : 0;
+    for (int i = 0; i < n; i++) {
+        const float edge = min(max(0, o), range);
+        if (o == edge) { // exact integral of exponentially decaying velocity
+            const float decay = expf(-h / scroll_friction);
+            o += v * scroll_friction * (1 - decay);
+            v *= decay;
+        } else { // overscroll: spring pulls back to the edge without oscillation
+            const float w = 1 / scroll_spring;
+            v += (-w * w * (o - edge) - 2 * w * v) * h;
+            o += v * h;
+        }
+    }
+    const float edge = min(max(0, o), range);
+    const bool slow = fabsf(v) < scroll_min_velocity * scroll_inch();
+    if (slow && fabsf(o - edge) < 0.5f) { o = edge; v = 0; }
+    *offset = o;
+    *velocity = v;
+    return v != 0 || o != edge;
+}
+
+static void scroll_motion(animation_t* motion) {
+    scroll_t* s = (scroll_t*)motion->that;
+    const uint64_t now = app->time_in_nanoseconds;
+    const float dt = min(0.05f, (float)(now - s->step_ns) / NS_IN_SEC); // stalls do not jump
+    s->step_ns = now;
+    const pointf_t range = scroll_range(s);
+    float ox = s->offset.x; // pointf_t is packed: axes are stepped in aligned locals
+    float oy = s->offset.y;
+    float vx = s->velocity.x;
+    float vy = s->velocity.y;
+    const bool x = scroll_axis(&ox, &vx, range.x, dt);
+    const bool y = scroll_axis(&oy, &vy, range.y, dt);
+    s->offset = (pointf_t){ox, oy};
+    s->velocity = (pointf_t){vx, vy};
+    if (!x && !y) { scroll_stop(s); }
+    scroll_moved(s);
+}
+
+static void scroll_animate(scroll_t* s) {
+    if (!s->motion.active) {
+        s->step_ns = app->time_in_nanoseconds;
+        animation_start(&s->motion);
+    }
+}
+
+static void scroll_sample(scroll_t* s, float x, float y) {
+    s->samples[s->sample].xy = (pointf_t){x, y};
+    s->samples[s->sample].ns = app->time_in_nanoseconds;
+    s->sample = (s->sample + 1) % SCROLL_SAMPLES;
+    s->samples_count = min(s->samples_count + 1, SCROLL_SAMPLES);
+}
+
+static pointf_t scroll_estimate(scroll_t* s) { // finger velocity: least squares slope of recent samples
+    const int newest = (s->sample + SCROLL_SAMPLES - 1) % SCROLL_SAMPLES;
+    const uint64_t t0 = s->samples[newest].ns;
+    double st = 0; // sums of t, x, y, t^2, t * x, t * y
+    double sx = 0;
+    double sy = 0;
+    double stt = 0;
+    double stx = 0;
+    double sty = 0;
+    int n = 0;
+    for (int i = 0; i < s->samples_count; i++) {
+        const int k = (newest - i + SCROLL_SAMPLES) % SCROLL_SAMPLES;
+        const double t = -(double)(t0 - s->samples[k].ns) / NS_IN_SEC;
+        if (t < -scroll_window) { break; } // finger that paused before release does not fling
+        const double x = s->samples[k].xy.x;
+        const double y = s->samples[k].xy.y;
+        st += t;
+        sx += x;
+        sy += y;
+        stt += t * t;
+        stx += t * x;
+        sty += t * y;
+        n++;
+    }
+    const double d = n * stt - st * st;
+    if (n < 2 || d <= 0) { return (pointf_t){0, 0}; }
+    return (pointf_t){ (n * stx - st * sx) / d, (n * sty - st * sy) / d };
+}
+
+static float scroll_drag_axis(float o, float d, float range, float extent) {
+    const float over = o < 0 ? -o : (o > range ? o - range : 0);
+    const bool outward = (o + d < 0 && d < 0) || (o + d > range && d > 0);
+    // rubber band: half of the finger travel, nothing at overscroll of half the extent
+    if (outward) { d *= 0.5f * max(0, 1 - over * 2 / extent); }
+    return o + d;
+}
+
+static void scroll_fling(scroll_t* s) {
+    const pointf_t v = scroll_estimate(s);
+    const pointf_t range = scroll_range(s);
+    const float limit = scroll_max_velocity * scroll_inch();
+    // finger moving up scrolls content up: offset grows
+    s->velocity.x = range.x > 0 ? min(max(-limit, -v.x), limit) : 0;
+    s->velocity.y = range.y > 0 ? min(max(-limit, -v.y), limit) : 0;
+    if (hypotf(s->velocity.x, s->velocity.y) < scroll_min_velocity * scroll_inch()) {
+        s->velocity = (pointf_t){0, 0};
+    }
+}
+
+static void scroll_drag(scroll_t* s, int touch_action, float x, float y) { // x, y screen
+    // captured pointer: dragging continues when the finger leaves the scroll bounds
+    ui_t* u = &s->u;
+    if (touch_action & (TOUCH_MOVE | TOUCH_UP)) { scroll_sample(s, x, y); }
+    if (touch_action & TOUCH_MOVE) {
+        const pointf_t range = scroll_range(s);
+        const float dx = s->drag.x - x;
+        const float dy = s->drag.y - y;
+        // travel along the axis that does not scroll leaves the pointer to children
+        const float travel = hypotf(range.x > 0 ? dx : 0, range.y > 0 ? dy : 0);
+        if (!s->dragging && travel >= scroll_slop * scroll_inch()) {
+            s->dragging = true;
+            s->drag = (pointf_t){x, y}; // content does not jump by the slop
+        } else if (s->dragging) {
+            if (range.x > 0) { s->offset.x = scroll_drag_axis(s->offset.x, dx, range.x, u->w); }
+            if (range.y > 0) { s->offset.y = scroll_drag_axis(s->offset.y, dy, range.y, u->h); }
+            s->drag = (pointf_t){x, y};
+            scroll_moved(s);
+        }
+        if (s->dragging) { ui.capture(u); } // exclusive: pressed children are disarmed
+    }
+    if (touch_action & TOUCH_UP) {
+        if (s->dragging) { scroll_fling(s); }
+        s->pressed = false;
+        s->dragging = false;
+        if (s->velocity.x != 0 || s->velocity.y != 0 || !scroll_inside(s)) { scroll_animate(s); }
+    }
+}
+
+static bool scroll_touch(ui_t* u, int touch_action, float x, float y) {
+    scroll_t* s = (scroll_t*)u;
+    const pointf_t p = ui.screen_xy(u);
+    if (touch_action & TOUCH_DOWN) {
+        ui.capture(u);
+        s->dragging = s->motion.active; // catching moving content drags it without slop
+        scroll_stop(s);
+        s->pressed = true;
+        s->drag = (pointf_t){p.x + x, p.y + y};
+        s->samples_count = 0;
+        scroll_sample(s, s->drag.x, s->drag.y);
+    } else if (s->pressed) {
+        scroll_drag(s, touch_action, p.x + x, p.y + y);
+    }
+    if (touch_action & MOUSE_WHEEL) {
+        font_t* f = u->a->theme.font;
+        const float lines = (f != null ? f->height : scroll_inch() / 6) * 3;
+        scroll_to(s, s->offset.x + u->a->wheel_x * lines, s->offset.y - u->a->wheel_y * lines);
+    }
+    return (touch_action & (TOUCH_DOWN | MOUSE_WHEEL)) != 0 || s->dragging;
+}
+
+static void scroll_draw(ui_t* u) {
+    scroll_t* s = (scroll_t*)u;
+    if (!s->motion.active && !s->pressed && !scroll_inside(s)) { scroll_clamp(s); } // resized
+    const rectf_t r = ui.screen_rect(u);
+    const rectf_t k = dc.clipping; // of the frame, empty when not clipped
+    float x0 = r.x;
+    float y0 = r.y;
+    float x1 = r.x + r.w;
+    float y1 = r.y + r.h;
+    if (k.w > 0 && k.h > 0) {
+        x0 = max(x0, k.x);
+        y0 = max(y0, k.y);
+        x1 = min(x1, k.x + k.w);
+        y1 = min(y1, k.y + k.h);
+    }
+    if (x0 < x1 && y0 < y1) {
+        dc.clip(&dc, x0, y0, x1 - x0, y1 - y0);
+        if (s->background != null) { dc.fill(&dc, s->background, r.x, r.y, r.w, r.h); }
+        u->draw_children(u);
+        dc.clip(&dc, k.x, k.y, k.w, k.h); // restores frame clipping or turns it off
+    }
+}
+
+void scroll_content_size(scroll_t* s, float w, float h) {
+    if (s->content.w != w || s->content.h != h) {
+        ui.set_bounds(&s->content, 0, 0, w, h);
+        ui.invalidate(&s->u);
+    }
+    if (!s->motion.active && !s->pressed) { scroll_clamp(s); } // otherwise spring brings it back
+}
+
+void scroll_to(scroll_t* s, float x, float y) {
+    scroll_stop(s);
+    s->offset = (pointf_t){x, y};
+    scroll_clamp(s);
+}
+
+void scroll_init(scroll_t* s, ui_t* parent, void* that, float x, float y, float w, float h) {
+    assert((void*)s == (void*)&s->u);
+    memset(s, 0, sizeof(*s));
+    ui.init(&s->u, parent, that, x, y, w, h);
+    ui.scroll(&s->u, 0, 0); // before content: nothing under the scroll is spatially indexed
+    ui.init(&s->content, &s->u, that, 0, 0, w, h);
+    s->u.kind = UI_KIND_SCROLL;
+    s->u.draw = scroll_draw;
+    s->u.touch = scroll_touch;
+    s->motion.that = s;
+    s->motion.step = scroll_motion;
+}
+
+void scroll_done(scroll_t* s) {
+    scroll_stop(s);
+    ui.done(&s->content);
+    ui.done(&s->u);
+    memset(s, 0, sizeof(*s));
+}
+
+end_c
@@ -11,6 +11,7 @@
 #include "shaders.h"
 #include "glh.h"
 #include "rt.h"
+#include "app.h"
 #include <GLES/gl.h>
 #include <GLES3/gl3.h>
 
@@ -94,6 +95,25 @@ const char* shader_luma_px = "\
         gl_FragColor = vec4(rgba[0], rgba[1], rgba[2], rgba[3] * c[3]); \n\
     }";
 
+// shaders.sdf blend signed distance field 1 component alpha texture with rgba color
+// uniform sampler2D tex (texture index e.g. 1 for GL_TEXTURE1)
+// uniform rgba
+// uniform smoothing half width of antialiased edge in texture value units
+// in vec4 xyts       [0..w] [0..h] [0..1], [0..1]
+
+const char* shader_sdf_px = "\
+    #version 100             \n\
+    precision highp float;   \n\
+    uniform highp vec4 rgba; \n\
+    uniform sampler2D  tex;  \n\
+    uniform float smoothing; \n\
+    varying highp vec2 ts;   \n\
+    void main() {                                                       \n\
+        float d = texture2D(tex, ts)[3];                                \n\
+        float a = smoothstep(0.5 - smoothing, 0.5 + smoothing, d);      \n\
+        gl_FragColor = vec4(rgba[0], rgba[1], rgba[2], rgba[3] * a);    \n\
+    }";
+
 // shaders.ring
 // in vec4 quad with [x, y, t, s] where ts are 0, 1 interpolated
 // in ri2 inner  radius ^ 2 (inclusive) [0..1]
@@ -167,6 +187,15 @@ static int shader_create_compile_and_attach(int program, gl_shader_source_t* s)
     return r;
 }
 
+static bool binaries; // GLES 3.0+ with at least one program binary format
+
+static void trace_link_errors(int program) {
+    GLsizei count = 0;
+    char message[1024] = {};
+    glGetProgramInfoLog(program, countof(message) - 1, &count, message);
+    traceln("link error: %s", message);
+}
+
 int shader_program_create_and_link(int* program, gl_shader_source_t sources[], int count) {
     int r = 0;
     GLint p = gl_check_call_int(glCreateProgram());
@@ -179,7 +208,15 @@ int shader_program_create_and_link(int* program, gl_shader_source_t sources[], i
             r = shader_create_compile_and_attach(p, &sources[i]);
         }
     }
+    if (r == 0 && binaries) {
+        gl_if_no_error(r, glProgramParameteri(p, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
     gl_if_no_error(r, glLinkProgram(p));
+    if (r == 0) {
+        GLint linked = false;
+        gl_if_no_error(r, glGetProgramiv(p, GL_LINK_STATUS, &linked));
+        if (r == 0 && !linked) { trace_link_errors(p); r = EINVAL; }
+    }
     if (r != 0) { shader_program_dispose(p); *program = 0; }
     return r;
 }
@@ -192,17 +229,204 @@ int shader_program_dispose(int program) {
 
 shaders_t shaders;
 
+// Program binary cache: glGetProgramBinary()/glProgramBinary() on GLES 3.0+
+// Binaries are keyed by hash of shader sources and GL_VENDOR, GL_RENDERER,
+// GL_VERSION strings (driver update changes the key). Binaries are kept in
+// memory (survive surface loss) and in sys.data_folder() (survive restart).
+// Binary rejected by the driver is evicted and program is recompiled.
+
+enum { PROGRAM_CACHE_MAX = 16 };
+
+typedef struct program_binary_s {
+    uint64_t key;
+    int format;
+    int bytes;
+    void* data;
+} program_binary_t;
+
+typedef struct program_binary_header_s { // file layout
+    char magic[4]; // "GLPB"
+    int format;
+    int bytes;
+    uint64_t key;
+} packed program_binary_header_t;
+
+static program_binary_t program_cache[PROGRAM_CACHE_MAX];
+
+static bool binaries_supported() {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int major = 0;
+    if (version != null) { sscanf(version, "OpenGL ES %d", &major); }
+    int formats = 0;
+    if (major >= 3) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        while (glGetError() != GL_NO_ERROR) { } // not an error if unsupported
+    }
+    return formats > 0;
+}
+
+static uint64_t fnv1a(uint64_t h, const char* s) {
+    if (s != null) {
+        while (*s != 0) { h ^= (byte)*s++; h *= 0x100000001B3ULL; }
+    }
+    h ^= 0xFF; h *= 0x100000001B3ULL; // separator
+    return h;
+}
+
+static uint64_t program_key(const char* vs, const char* fs) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    h = fnv1a(h, (const char*)glGetString(GL_VENDOR));
+    h = fnv1a(h, (const char*)glGetString(GL_RENDERER));
+    h = fnv1a(h, (const char*)glGetString(GL_VERSION));
+    h = fnv1a(h, vs);
+    h = fnv1a(h, fs);
+    return h;
+}
+
+// open addressed: linear probing from key % PROGRAM_CACHE_MAX over all slots
+
+static program_binary_t* program_cache_find(uint64_t key) {
+    for (int i = 0; i < countof(program_cache); i++) {
+        program_binary_t* pb = &program_cache[(key + i) % countof(program_cache)];
+        if (pb->data != null && pb->key == key) { return pb; }
+    }
+    return null;
+}
+
+static program_binary_t* program_cache_slot(uint64_t key) {
+    program_binary_t* pb = program_cache_find(key);
+    for (int i = 0; pb == null && i < countof(program_cache); i++) {
+        program_binary_t* e = &program_cache[(key + i) % countof(program_cache)];
+        if (e->data == null) { pb = e; }
+    }
+    // all slots taken by other programs: the home slot is replaced
+    return pb != null ? pb : &program_cache[key % countof(program_cache)];
+}
+
+static void program_binary_path(char* path, int count, uint64_t key) {
+    const char* folder = sys.data_folder != null ? sys.data_folder(app) : null;
+    path[0] = 0;
+    if (folder != null) {
+        snprintf(path, count, "%s/program-%016llX.bin", folder, (unsigned long long)key);
+        path[count - 1] = 0;
+    }
+}
+
+static void program_cache_evict(uint64_t key) {
+    program_binary_t* pb = program_cache_find(key);
+    if (pb != null) {
+        deallocate(pb->data);
+        memset(pb, 0, sizeof(*pb));
+    }
+    char path[1024];
+    program_binary_path(path, countof(path), key);
+    if (path[0] != 0) { unlink(path); }
+}
+
+static void program_cache_put(uint64_t key, int format, void* data, int bytes) {
+    program_binary_t* pb = program_cache_slot(key);
+    deallocate(pb->data);
+    pb->key = key;
+    pb->format = format;
+    pb->data = data;
+    pb->bytes = bytes;
+}
+
+static program_binary_t* program_cache_read(uint64_t key) {
+    program_binary_t* pb = program_cache_find(key);
+    if (pb != null) { return pb; }
+    char path[1024];
+    program_binary_path(path, countof(path), key);
+    FILE* f = path[0] != 0 ? fopen(path, "rb") : null;
+    if (f != null) {
+        program_binary_header_t h = {};
+        void* data = null;
+        bool valid = fread(&h, sizeof(h), 1, f) == 1 && memcmp(h.magic, "GLPB", 4) == 0 &&
+                     h.key == key && 0 < h.bytes && h.bytes < 16 * 1024 * 1024;
+        if (valid) {
+            data = allocate(h.bytes);
+            valid = data != null && fread(data, h.bytes, 1, f) == 1;
+        }
+        fclose(f);
+        if (valid) {
+            program_cache_put(key, h.format, data, h.bytes);
+            return program_cache_find(key);
+        }
+        deallocate(data);
+        unlink(path);
+    }
+    return null;
+}
+
+static void program_cache_write(int program, uint64_t key) {
+    GLint bytes = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &bytes);
+    void* data = bytes > 0 ? allocate(bytes) : null;
+    if (data != null) {
+        GLsizei length = 0;
+        GLenum format = 0;
+        glGetProgramBinary(program, bytes, &length, &format, data);
+        if (glGetError() != GL_NO_ERROR || length <= 0) {
+            deallocate(data);
+        } else {
+            program_cache_put(key, format, data, length);
+            char path[1024];
+            program_binary_path(path, countof(path), key);
+            char temp[1024 + 8];
+            snprintf0(temp, "%s.tmp", path);
+            FILE* f = path[0] != 0 ? fopen(temp, "wb") : null;
+            if (f != null) {
+                program_binary_header_t h = { {'G', 'L', 'P', 'B'}, (int)format, (int)length, key };
+                bool written = fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(data, length, 1, f) == 1;
+                written = fclose(f) == 0 && written;
+                if (!written || rename(temp, path) != 0) { unlink(temp); }
+            }
+        }
+    }
+}
+
+static int program_from_binary(int* program, uint64_t key) {
+    int r = ENOENT;
+    program_binary_t* pb = program_cache_read(key);
+    if (pb != null) {
+        GLuint p = glCreateProgram();
+        if (p == 0) {
+            r = ENOMEM;
+        } else {
+            // glProgramBinary() fails with GL_INVALID_ENUM for unknown formats, not a bug
+            glProgramBinary(p, pb->format, pb->data, pb->bytes);
+            while (glGetError() != GL_NO_ERROR) { }
+            GLint linked = false;
+            glGetProgramiv(p, GL_LINK_STATUS, &linked);
+            if (linked) {
+                *program = p;
+                r = 0;
+            } else {
+                traceln("program binary %016llX rejected", (unsigned long long)key);
+                glDeleteProgram(p);
+                program_cache_evict(key);
+                r = EINVAL;
+            }
+        }
+    }
+    return r;
+}
+
 static int create_and_link_program(int *program,
                                    const char* vertex, const char* vs,
                                    const char* fragment, const char* fs) {
     *program = 0;
-    int r = 0;
-    gl_shader_source_t sources[] = {
-        {GL_SHADER_VERTEX,   vertex,   vs, (int)strlen(vs)},
-        {GL_SHADER_FRAGMENT, fragment, fs, (int)strlen(fs)}
-    };
-    r = shader_program_create_and_link(program, sources, countof(sources));
-    assert(r == 0);
+    const uint64_t key = binaries ? program_key(vs, fs) : 0;
+    int r = binaries ? program_from_binary(program, key) : ENOENT;
+    if (r != 0) {
+        gl_shader_source_t sources[] = {
+            {GL_SHADER_VERTEX,   vertex,   vs, (int)strlen(vs)},
+            {GL_SHADER_FRAGMENT, fragment, fs, (int)strlen(fs)}
+        };
+        r = shader_program_create_and_link(program, sources, countof(sources));
+        assert(r == 0);
+        if (r == 0 && binaries) { program_cache_write(*program, key); }
+    }
     return r;
 }
 
@@ -210,10 +434,12 @@ static int create_and_link_program(int *program,
 
 int shaders_init() {
     int r = 0;
+    binaries = binaries_supported();
     if (r == 0) { r = create_program(&shaders.fill, shader_fill_vx, shader_fill_px); }
     if (r == 0) { r = create_program(&shaders.bblt, shader_bblt_vx, shader_bblt_px); }
     if (r == 0) { r = create_program(&shaders.luma, shader_luma_vx, shader_luma_px); }
     if (r == 0) { r = create_program(&shaders.ring, shader_ring_vx, shader_ring_px); }
+    if (r == 0) { r = create_program(&shaders.sdf,  shader_luma_vx, shader_sdf_px); }
     if (r == 0) { // glsl compiler removes unused uniforms and in/out (attributes/varyings)
         shaders.fill_mvp  = gl_check_int_call(r, glGetUniformLocation(shaders.fill, "mvp"));
         shaders.fill_rgba = gl_check_int_call(r, glGetUniformLocation(shaders.fill, "rgba"));
@@ -232,6 +458,12 @@ int shaders_init() {
         shaders.ring_ri2  = gl_check_int_call(r, glGetUniformLocation(shaders.ring, "ri2"));
         assert(shaders.ring_mvp >= 0 && shaders.ring_rgba >= 0);
         assert(shaders.ring_ro2 >= 0 && shaders.ring_ri2 >= 0);
+        shaders.sdf_mvp  = gl_check_int_call(r, glGetUniformLocation(shaders.sdf, "mvp"));
+        shaders.sdf_tex  = gl_check_int_call(r, glGetUniformLocation(shaders.sdf, "tex"));
+        shaders.sdf_rgba = gl_check_int_call(r, glGetUniformLocation(shaders.sdf, "rgba"));
+        shaders.sdf_smoothing = gl_check_int_call(r, glGetUniformLocation(shaders.sdf, "smoothing"));
+        assert(shaders.sdf_mvp >= 0 && shaders.sdf_rgba >= 0);
+        assert(shaders.sdf_tex >= 0 && shaders.sdf_smoothing >= 0);
     }
     assert(r == 0);
     return r;
@@ -242,6 +474,7 @@ void shaders_dispose() { // glDeleteProgram(0) is legal NOOP
     shader_program_dispose(shaders.bblt);
     shader_program_dispose(shaders.luma);
     shader_program_dispose(shaders.ring);
+    shader_program_dispose(shaders.sdf);
     memset(&shaders, 0, sizeof(shaders));
 }
 
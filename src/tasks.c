@@ -0,0 +1,186 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "tasks.h"
+
+begin_c
+
+enum {
+    TASK_WAITING = 0,
+    TASK_RUNNING = 1,
+    TASK_DONE    = 2
+};
+
+typedef struct tasks_s {
+    task_t** tasks;
+    int count;
+    int remaining;
+    int workers;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+} tasks_t;
+
+typedef struct worker_s {
+    tasks_t* ts;
+    int thread;
+} worker_t;
+
+uint64_t tasks_time_ns() {
+    struct timespec tm = {};
+    clock_gettime(CLOCK_MONOTONIC, &tm);
+    return (uint64_t)tm.tv_sec * 1000000000ULL + tm.tv_nsec;
+}
+
+static task_t* ready(tasks_t* ts, bool gl) { // called with mutex locked
+    for (int i = 0; i < ts->count; i++) {
+        task_t* t = ts->tasks[i];
+        if (t->state == TASK_WAITING && t->pending == 0 && t->gl == gl) { return t; }
+    }
+    return null;
+}
+
+static void execute(tasks_t* ts, task_t* t, int thread) { // called with mutex locked
+    t->state = TASK_RUNNING;
+    t->thread = thread;
+    pthread_mutex_unlock(&ts->mutex);
+    t->start_ns = tasks_time_ns();
+    t->run(t);
+    t->end_ns = tasks_time_ns();
+    pthread_mutex_lock(&ts->mutex);
+    t->state = TASK_DONE;
+    ts->remaining--;
+    for (int i = 0; i < ts->count; i++) {
+        task_t* u = ts->tasks[i];
+        for (int j = 0; j < countof(u->deps); j++) {
+            if (u->deps[j] == t) { u->pending--; }
+        }
+    }
+    pthread_cond_broadcast(&ts->cond);
+}
+
+static void* worker(void* p) {
+    worker_t* w = (worker_t*)p;
+    tasks_t* ts = w->ts;
+    pthread_mutex_lock(&ts->mutex);
+    while (ts->remaining > 0) {
+        task_t* t = ready(ts, false);
+        if (t != null) {
+            execute(ts, t, w->thread);
+        } else {
+            pthread_cond_wait(&ts->cond, &ts->mutex);
+        }
+    }
+    pthread_mutex_unlock(&ts->mutex);
+    return null;
+}
+
+static void report(const char* label, tasks_t* ts, uint64_t start, uint64_t end) {
+    const double ms = 1.0 / 1000000.0; // ns to ms
+    traceln("%s: %.1fms %d tasks %d workers", label, (end - start) * ms, ts->count, ts->workers);
+    for (int i = 0; i < ts->count; i++) {
+        task_t* t = ts->tasks[i];
+        traceln("  %-24s %7.1fms [%7.1f..%7.1f] %s%d", t->name,
+                (t->end_ns - t->start_ns) * ms, (t->start_ns - start) * ms, (t->end_ns - start) * ms,
+                t->thread == 0 ? "gl" : "worker", t->thread);
+    }
+}
+
+void tasks_run(const char* label, task_t* tasks[], int count) {
+    tasks_t ts = {};
+    ts.tasks = tasks;
+    ts.count = count;
+    ts.remaining = count;
+    int cpu = 0;
+    for (int i = 0; i < count; i++) {
+        task_t* t = tasks[i];
+        t->state = TASK_WAITING;
+        t->pending = 0;
+        for (int j = 0; j < countof(t->deps); j++) { t->pending += t->deps[j] != null; }
+        cpu += !t->gl;
+    }
+    const int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    ts.workers = max(1, min(min(cpu, cores - 1), TASKS_MAX_WORKERS));
+    pthread_mutex_init(&ts.mutex, null);
+    pthread_cond_init(&ts.cond, null);
+    const uint64_t start = tasks_time_ns();
+    pthread_t threads[TASKS_MAX_WORKERS] = {};
+    worker_t workers[TASKS_MAX_WORKERS] = {};
+    for (int i = 0; i < ts.workers && cpu > 0; i++) {
+        workers[i].ts = &ts;
+        workers[i].thread = i + 1;
+        int r = pthread_create(&threads[i], null, worker, &workers[i]);
+        assertion(r == 0, "pthread_create() failed %s", strerror(r));
+        if (r != 0) { threads[i] = 0; }
+    }
+    pthread_mutex_lock(&ts.mutex);
+    while (ts.remaining > 0) {
+        task_t* t = ready(&ts, true);
+        if (t == null && threads[0] == 0) { t = ready(&ts, false); } // no workers
+        if (t != null) {
+            execute(&ts, t, 0);
+        } else {
+            pthread_cond_wait(&ts.cond, &ts.mutex);
+        }
+    }
+    pthread_mutex_unlock(&ts.mutex);
+    for (int i = 0; i < ts.workers; i++) {
+        if (threads[i] != 0) { pthread_join(threads[i], null); }
+    }
+    report(label, &ts, start, tasks_time_ns());
+    pthread_cond_destroy(&ts.cond);
+    pthread_mutex_destroy(&ts.mutex);
+}
+
+typedef struct parallel_for_s {
+    int count;
+    int next; // first unclaimed index
+    int r;    // first error
+    int (*body)(void* that, int i);
+    void* that;
+    pthread_mutex_t mutex;
+} parallel_for_t;
+
+static void* parallel_for_worker(void* p) {
+    parallel_for_t* pf = (parallel_for_t*)p;
+    pthread_mutex_lock(&pf->mutex);
+    while (pf->next < pf->count && pf->r == 0) {
+        const int i = pf->next++;
+        pthread_mutex_unlock(&pf->mutex);
+        int r = pf->body(pf->that, i);
+        pthread_mutex_lock(&pf->mutex);
+        if (r != 0 && pf->r == 0) { pf->r = r; }
+    }
+    pthread_mutex_unlock(&pf->mutex);
+    return null;
+}
+
+int tasks_parallel_for(int count, int (*body)(void* that, int i), void* that) {
+    parallel_for_t pf = {};
+    pf.count = count;
+    pf.body = body;
+    pf.that = that;
+    pthread_mutex_init(&pf.mutex, null);
+    const int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const int workers = max(0, min(min(count - 1, cores - 1), TASKS_MAX_WORKERS));
+    pthread_t threads[TASKS_MAX_WORKERS] = {};
+    for (int i = 0; i < workers; i++) {
+        int r = pthread_create(&threads[i], null, parallel_for_worker, &pf);
+        assertion(r == 0, "pthread_create() failed %s", strerror(r));
+        if (r != 0) { threads[i] = 0; } // calling thread does the rest
+    }
+    parallel_for_worker(&pf);
+    for (int i = 0; i < workers; i++) {
+        if (threads[i] != 0) { pthread_join(threads[i], null); }
+    }
+    pthread_mutex_destroy(&pf.mutex);
+    return pf.r;
+}
+
+end_c
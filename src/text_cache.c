@@ -0,0 +1,121 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "text_cache.h"
+#include "rt.h"
+
+begin_c
+
+enum { TEXT_CACHE_BUCKETS = 256 }; // power of 2
+
+typedef struct text_cache_s {
+    text_run_t* buckets[TEXT_CACHE_BUCKETS];
+    int bytes;      // allocated by all runs
+    uint32_t frame;
+} text_cache_t;
+
+static text_cache_t cache;
+
+static uint64_t fnv1a(const char* text, int bytes) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (int i = 0; i < bytes; i++) { h ^= (byte)text[i]; h *= 0x100000001B3ULL; }
+    return h;
+}
+
+static text_run_t** bucket(uint64_t hash) {
+    return &cache.buckets[(hash ^ (hash >> 32)) & (TEXT_CACHE_BUCKETS - 1)];
+}
+
+static void release(text_run_t** p) { // removes *p from bucket chain
+    text_run_t* r = *p;
+    *p = r->next;
+    cache.bytes -= r->size;
+    deallocate(r);
+}
+
+static bool evict_lru() {
+    text_run_t** lru = null;
+    for (int i = 0; i < TEXT_CACHE_BUCKETS; i++) {
+        for (text_run_t** p = &cache.buckets[i]; *p != null; p = &(*p)->next) {
+            if (lru == null || (*p)->used < (*lru)->used) { lru = p; }
+        }
+    }
+    if (lru != null) { release(lru); }
+    return lru != null;
+}
+
+const text_run_t* text_cache_find(font_t* f, const char* text, int bytes) {
+    const uint64_t hash = fnv1a(text, bytes);
+    for (text_run_t* r = *bucket(hash); r != null; r = r->next) {
+        if (r->font == f && r->hash == hash && r->bytes == bytes && memcmp(r->text, text, bytes) == 0) {
+            r->used = cache.frame;
+            return r;
+        }
+    }
+    return null;
+}
+
+const text_run_t* text_cache_put(font_t* f, const char* text, int bytes,
+                                 const quadf_t* quads, int count, float advance) {
+    const int quads_bytes = count * 4 * sizeof(quadf_t);
+    const int size = sizeof(text_run_t) + quads_bytes + bytes;
+    if (size > TEXT_CACHE_BUDGET / 4) { return null; } // not worth caching
+    while (cache.bytes + size > TEXT_CACHE_BUDGET && evict_lru()) { }
+    text_run_t* r = (text_run_t*)allocate(size);
+    if (r != null) {
+        r->font = f;
+        r->base = f->base;
+        r->hash = fnv1a(text, bytes);
+        r->bytes = bytes;
+        r->count = count;
+        r->advance = advance;
+        r->used = cache.frame;
+        r->size = size;
+        r->quads = (quadf_t*)(r + 1);
+        r->text = (char*)r->quads + quads_bytes;
+        memcpy(r->quads, quads, quads_bytes);
+        memcpy(r->text, text, bytes);
+        text_run_t** b = bucket(r->hash);
+        r->next = *b;
+        *b = r;
+        cache.bytes += size;
+    }
+    return r;
+}
+
+void text_cache_frame() {
+    cache.frame++;
+    if (cache.frame % 16 == 0) { // no need to scan every frame
+        for (int i = 0; i < TEXT_CACHE_BUCKETS; i++) {
+            text_run_t** p = &cache.buckets[i];
+            while (*p != null) {
+                if (cache.frame - (*p)->used > TEXT_CACHE_MAX_AGE) { release(p); } else { p = &(*p)->next; }
+            }
+        }
+    }
+}
+
+void text_cache_remove(font_t* f) {
+    for (int i = 0; i < TEXT_CACHE_BUCKETS; i++) {
+        text_run_t** p = &cache.buckets[i];
+        while (*p != null) {
+            if ((*p)->font == f || (*p)->base == f) { release(p); } else { p = &(*p)->next; }
+        }
+    }
+}
+
+void text_cache_clear() {
+    for (int i = 0; i < TEXT_CACHE_BUCKETS; i++) {
+        while (cache.buckets[i] != null) { release(&cache.buckets[i]); }
+    }
+    assert(cache.bytes == 0);
+}
+
+end_c
@@ -13,9 +13,43 @@
 #include "glh.h"
 #include "stb_inc.h"
 #include "stb_image.h"
+#include "lz4.h"
 
 begin_c
 
+static int load_compressed(texture_t* b, const void* data, int bytes) {
+    int r = 0;
+    const texture_cache_header_t* h = (const texture_cache_header_t*)data;
+    int n = 0;
+    if (bytes < (int)sizeof(*h) || memcmp(h->magic, TEXTURE_CACHE_MAGIC, sizeof(h->magic)) != 0 ||
+        h->w <= 0 || h->h <= 0 || h->comp < 1 || h->comp > 4) {
+        r = EINVAL;
+    } else { // header is in bounds, corrupt or crafted sizes must not overflow
+        const int64_t size = (int64_t)h->w * h->h * h->comp;
+        if (size > INT32_MAX) { r = EINVAL; } else { n = (int)size; }
+    }
+    if (r == 0) {
+        b->data = allocate(n);
+        if (b->data == null) {
+            r = ENOMEM;
+        } else {
+            int decoded = 0; // decompress straight into texture data, no intermediate copy
+            r = lz4_decode((const byte*)data + sizeof(*h), bytes - sizeof(*h), b->data, n, &decoded);
+            if (r == 0 && decoded != n) { r = EINVAL; }
+        }
+        if (r == 0) {
+            b->w = h->w;
+            b->h = h->h;
+            b->comp = h->comp;
+            b->ti = 0;
+        } else {
+            deallocate(b->data);
+            b->data = null;
+        }
+    }
+    return r;
+}
+
 static int load_asset(texture_t* b, app_t* a, const char* name) {
     int r = 0;
     const void* data = null;
@@ -26,6 +60,9 @@ static int load_asset(texture_t* b, app_t* a, const char* name) {
     void* asset = sys.asset_map(a, name, &data, &bytes);
     if (asset == null) {
         r = errno;
+    } else if (lz4_is_compressed(name)) {
+        r = load_compressed(b, data, bytes);
+        sys.asset_unmap(a, asset, data, bytes);
     } else {
         byte* p = null;
         if (stbi_info_from_memory((const byte*)data, bytes, &w, &h, &bytes_per_pixel)) {
@@ -76,6 +113,17 @@ int texture_update(texture_t* b) {
     return gl_update(b->ti, b->w, b->h, b->comp, b->data);
 }
 
+int texture_linear(texture_t* b) {
+    return gl_linear(b->ti);
+}
+
+int texture_update_rows(texture_t* b, int y, int h) {
+    assert(0 <= y && h > 0 && y + h <= b->h);
+    // GLES2 has no GL_UNPACK_ROW_LENGTH thus whole rows are uploaded
+    const byte* rows = (const byte*)b->data + y * b->w * b->comp;
+    return gl_update_sub(b->ti, 0, y, b->w, h, b->comp, rows);
+}
+
 int texture_allocate_and_update(texture_t* b) {
     assert(b->data != null && b->w > 0 && b->h > 0 && b->comp > 0);
     int r = texture_allocate(b);
@@ -10,7 +10,8 @@
    limitations under the License. */
 #include "toast.h"
 #include "app.h"
-#include "screen_writer.h"
+#include "animation.h"
+#include "paragraph.h"
 
 begin_c
 
@@ -25,110 +26,100 @@ typedef struct toast_s {
     void (*cancel)(toast_t* t);
     // implementation:
     char text[1024];
-    timer_callback_t toast_timer_callback;
-    uint64_t toast_start_time; // time toast started to be shown
+    animation_t animation; // keeps toast on screen and fades it out
+    float alpha;
+    paragraph_t paragraph; // text layout is cached between frames
 } toast_t;
 
 static toast_t* toast(app_t* a); // returns pointer to toast single instance
 
-static void timer_callback(timer_callback_t* timer_callback) {
-    app_t* a = (app_t*)timer_callback->that;
-    sys.invalidate(a);
+static float fade(float t) { return t < 0.75f ? 0 : (t - 0.75f) * 4; } // during the last quarter
+
+static void step(animation_t* animation) {
+    toast_t* t = (toast_t*)animation->that;
+    if (t->alpha < 1) { ui.invalidate(&t->ui); } // redrawn only while fading
+}
+
+static void done(animation_t* animation) {
+    toast_t* t = (toast_t*)animation->that;
+    t->cancel(t);
 }
 
 static void add(toast_t* t) {
     app_t* a = t->ui.a;
-    assert(t->toast_timer_callback.id == 0);
-    t->toast_timer_callback.id = 0;
-    t->toast_timer_callback.that = a;
-    t->toast_timer_callback.ns = t->nanoseconds + 1;
-    t->toast_timer_callback.callback = timer_callback;
-    t->toast_timer_callback.last_fired = 0;
-    sys.timer_add(a, &t->toast_timer_callback);
+    assert(!t->animation.active);
+    t->alpha = 1;
+    t->animation.that = t;
+    t->animation.value = &t->alpha;
+    t->animation.from = 1;
+    t->animation.to = 0;
+    t->animation.duration = t->nanoseconds;
+    t->animation.easing = fade;
+    t->animation.step = step;
+    t->animation.done = done;
+    animation_start(&t->animation);
     ui.add(&a->root, &t->ui, 0, 0, 0, 0);
 }
 
 static void cancel(toast_t* t) {
     // It is not an error to cancel inactive toast:
-    if (t->toast_timer_callback.id != 0) {
+    if (t->ui.parent != null) {
         app_t* a = t->ui.a;
-        sys.timer_remove(a, &t->toast_timer_callback);
-        memset(&t->toast_timer_callback, 0, sizeof(t->toast_timer_callback));
+        animation_stop(&t->animation);
         t->text[0] = 0; // toast OFF
-        t->toast_start_time = 0;
+        paragraph_dispose(&t->paragraph);
         assertion(t->ui.parent == &a->root, "toast() must be added to ui_root");
+        ui.invalidate(&t->ui); // erase
         ui.remove(&a->root, &t->ui);
-    } else {
-        assertion(t->ui.parent == null, "parent=%p expected null", t->ui.parent);
     }
 }
 
-static int measure(toast_t* t, float *w, float *h) {
-    font_t* f = t->ui.a->theme.font;
-    int n = 1;
-    char* s = t->text;
-    while (*s != 0) { n += *s == '\n'; s++; }
-    s = t->text;
-    for (int i = 0; i < n; i++) {
-        int k = 0;
-        char* line = s;
-        while (*s != 0 && *s != '\n') { k++; s++; }
-        if (*s == '\n') { s++; }
-        float width = font_text_width(f, line, k);
-        if (width > *w) { *w = width; }
-    }
-    *h = n * f->height;
-    return n;
+static bool layout(toast_t* t) { // sets toast bounds, returns false if text cannot be laid out
+    app_t* a = t->ui.a;
+    font_t* f = a->theme.font;
+    paragraph_t* p = &t->paragraph;
+    // long lines are wrapped to fit the screen, relayout only on text, font or width change
+    if (f == null || paragraph_layout(p, f, t->text, -1, a->root.w - f->em * 4) != 0) { return false; }
+    const float w = p->w + f->em * 2;
+    const float h = p->h + f->em * 2;
+    const float x = (int)((a->root.w - w) / 2);
+    const float y = (int)((a->root.h - h) / 2);
+    if (t->ui.x != x || t->ui.y != y || t->ui.w != w || t->ui.h != h) { ui.set_bounds(&t->ui, x, y, w, h); }
+    return true;
 }
 
 static void render(toast_t* t) {
     app_t* a = t->ui.a;
-    float w = 0;
-    float h = 0;
-    int n = measure(t, &w, &h);
     font_t* f = a->theme.font;
-    w += f->em * 2;
-    h += f->em * 2;
-    int x = (int)((a->root.w - w) / 2);
-    int y = (int)((a->root.h - h) / 2);
+    paragraph_t* p = &t->paragraph;
+    if (!layout(t)) { return; }
+    const rectf_t r = ui.screen_rect(&t->ui);
+    const float x = r.x;
+    const float y = r.y;
+    const float w = r.w;
+    const float h = r.h;
     colorf_t c = *colors_dk.light_gray;
-    c.a = 0.65;
+    c.a = 0.65 * t->alpha;
     dc.stadium(&dc, &c, x, y, w, h, f->em);
-    char* s = t->text;
-    screen_writer_t sw = screen_writer(0, y + f->em / 2 + f->height, f, colors.black);
-    for (int i = 0; i < n; i++) {
-        int k = 0;
-        char* line = s;
-        while (*s != 0 && *s != '\n') { k++; s++; }
-        if (*s == '\n') { s++; }
-        float width = font_text_width(f, line, k);
-        sw.x = x + (w - width) / 2;
-        sw.println(&sw, "%.*s", k, line);
+    colorf_t k = *colors.black;
+    k.a = t->alpha;
+    float baseline = y + f->em / 2 + f->height;
+    for (int i = 0; i < p->count; i++) {
+        const paragraph_line_t* line = &p->lines[i];
+        dc.text(&dc, &k, f, x + (w - line->width) / 2, baseline, p->text + line->start, line->bytes);
+        baseline += f->height;
     }
 }
 
 static void draw(ui_t* ui) {
     toast_t* t = ui->that;
-    app_t* a = ui->a;
-    if (t->text[0] != 0) {
-        if (t->toast_start_time == 0) { // first time drawn
-            t->toast_start_time = a->time_in_nanoseconds;
-        } else {
-            int64_t time_on_screen = a->time_in_nanoseconds - t->toast_start_time;
-            if (time_on_screen > t->nanoseconds) { // nanoseconds
-                cancel(t);
-            } else {
-                render(t);
-            }
-        }
-    }
+    if (t->text[0] != 0) { render(t); } // animation done() cancels expired toast
 }
 
 static void print(toast_t* t, const char* format, ...) {
-    if (t->toast_timer_callback.id != 0) { t->cancel(t); }
+    if (t->ui.parent != null) { t->cancel(t); }
     assertion(t->ui.parent == null, "parent=%d expected null", t->ui.parent);
-    assertion(t->toast_timer_callback.id == 0, "timer should not be active");
-    assertion(t->toast_start_time == 0, "toast_start_time expected 0");
+    assertion(!t->animation.active, "animation should not be active");
     va_list vl;
     va_start(vl, format);
     vsnprintf0(t->text, format, vl);
@@ -136,7 +127,7 @@ static void print(toast_t* t, const char* format, ...) {
     assert(t->text[0] != 0);
     t->ui.hidden = false;
     add(t);
-    sys.invalidate(t->ui.a);
+    if (layout(t)) { ui.invalidate(&t->ui); }
 }
 
 static toast_t* toast(app_t* a) {
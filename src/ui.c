@@ -9,10 +9,351 @@
    See the License for the specific language governing permissions and
    limitations under the License. */
 #include "ui.h"
+#include "ui_store.h"
 #include "app.h"
 
 begin_c
 
+static void ui_dirty(ui_t* u) { // dirty ui has dirty descendants, parentless ui is never cached
+    if (!u->dirty || u->parent == null) {
+        u->dirty = u->parent != null;
+        int first = 0;
+        int end = 0;
+        ui_store_t* s = ui_store_subtree(u, false, &first, &end);
+        if (s != null) { // pooled descendants are a range of pre-order array
+            for (int i = first; i < end; i++) { s->ui[i]->dirty = true; }
+        } else {
+            for (ui_t* c = u->children; c != null; c = c->next) { ui_dirty(c); }
+        }
+    }
+}
+
+#ifdef DEBUG
+
+static rectf_t ui_frame_rect_walk(ui_t* u, ui_t** frame) { // uncached, same order of additions
+    if (u->parent == null) { *frame = null; return (rectf_t){u->x, u->y, u->w, u->h}; }
+    if (u->parent->scrolls) { *frame = u->parent; return (rectf_t){u->x, u->y, u->w, u->h}; }
+    const rectf_t p = ui_frame_rect_walk(u->parent, frame);
+    return (rectf_t){p.x + u->x, p.y + u->y, u->w, u->h};
+}
+
+static rectf_t ui_screen_rect_walk(ui_t* u) {
+    ui_t* f = null;
+    rectf_t r = ui_frame_rect_walk(u, &f);
+    if (f != null) {
+        const rectf_t o = ui_screen_rect_walk(f);
+        r.x += o.x - f->offset.x;
+        r.y += o.y - f->offset.y;
+    }
+    return r;
+}
+
+#endif
+
+/* Spatial index: absolute bounds of every widget attached to app.root are
+   hashed into a uniform grid of UI_INDEX_CELL pixels cells. Widgets
+   covering more than UI_INDEX_LARGE cells (usually few big containers)
+   are kept in a short list instead. Point queries visit one cell and
+   the list instead of the whole tree. Descendants of ui.scroll()-ed ui
+   are not indexed (scrolling would move them all): hits of scrolling ui
+   are followed by a tree walk of its children. */
+
+enum {
+    UI_INDEX_CELL    = 64,   // pixels
+    UI_INDEX_LARGE   = 64,   // cells
+    UI_INDEX_BUCKETS = 1024, // power of 2
+    UI_INDEX_HITS    = 64    // touched widgets under a single point, tree walk beyond that
+};
+
+typedef struct ui_index_entry_s {
+    ui_t* u;
+    int x; // cell
+    int y;
+} ui_index_entry_t;
+
+typedef struct ui_index_bucket_s {
+    ui_index_entry_t* entries;
+    int count;
+    int capacity;
+} ui_index_bucket_t;
+
+typedef struct ui_index_s {
+    ui_index_bucket_t buckets[UI_INDEX_BUCKETS];
+    ui_t** large;
+    int large_count;
+    int large_capacity;
+    bool failed;   // out of memory: hit testing falls back to tree walk
+    bool numbered; // indexed.order and indexed.last of rooted ui are valid
+} ui_index_t;
+
+static ui_index_t ui_index;
+
+static ui_index_bucket_t* ui_index_bucket(int x, int y) {
+    const uint32_t h = (uint32_t)x * 0x9E3779B1u ^ (uint32_t)y * 0x85EBCA77u;
+    return &ui_index.buckets[(h ^ (h >> 16)) & (UI_INDEX_BUCKETS - 1)];
+}
+
+static bool ui_index_is_large(ui_t* u) {
+    return (u->indexed.x1 - u->indexed.x0 + 1) * (u->indexed.y1 - u->indexed.y0 + 1) > UI_INDEX_LARGE;
+}
+
+static bool ui_index_grow(void** p, int* capacity, int count, int size) {
+    if (count < *capacity) { return true; }
+    const int n = *capacity == 0 ? 8 : *capacity * 2;
+    void* a = reallocate(*p, n * size);
+    if (a != null) { *p = a; *capacity = n; }
+    return a != null;
+}
+
+static void ui_index_insert(ui_t* u) {
+    assert(!u->indexed.on);
+    const rectf_t r = ui.screen_rect(u);
+    u->indexed.x0 = (int)floorf(r.x / UI_INDEX_CELL);
+    u->indexed.y0 = (int)floorf(r.y / UI_INDEX_CELL);
+    u->indexed.x1 = r.w > 0 && r.h > 0 ? (int)floorf((r.x + r.w) / UI_INDEX_CELL) : u->indexed.x0 - 1;
+    u->indexed.y1 = r.w > 0 && r.h > 0 ? (int)floorf((r.y + r.h) / UI_INDEX_CELL) : u->indexed.y0 - 1;
+    u->indexed.on = true;
+    if (u->indexed.x1 < u->indexed.x0) {
+        // empty widget: nothing to hit
+    } else if (ui_index_is_large(u)) {
+        if (ui_index_grow((void**)&ui_index.large, &ui_index.large_capacity, ui_index.large_count, sizeof(ui_t*))) {
+            ui_index.large[ui_index.large_count++] = u;
+        } else {
+            ui_index.failed = true;
+        }
+    } else {
+        for (int cy = u->indexed.y0; cy <= u->indexed.y1; cy++) {
+            for (int cx = u->indexed.x0; cx <= u->indexed.x1; cx++) {
+                ui_index_bucket_t* b = ui_index_bucket(cx, cy);
+                if (ui_index_grow((void**)&b->entries, &b->capacity, b->count, sizeof(ui_index_entry_t))) {
+                    b->entries[b->count++] = (ui_index_entry_t){ u, cx, cy };
+                } else {
+                    ui_index.failed = true;
+                }
+            }
+        }
+    }
+    assertion(!ui_index.failed, "out of memory");
+}
+
+static void ui_index_erase(ui_t* u) {
+    assert(u->indexed.on);
+    if (u->indexed.x1 < u->indexed.x0) {
+        // empty widget
+    } else if (ui_index_is_large(u)) {
+        for (int i = 0; i < ui_index.large_count; i++) {
+            if (ui_index.large[i] == u) { ui_index.large[i] = ui_index.large[--ui_index.large_count]; break; }
+        }
+        if (ui_index.large_count == 0) {
+            deallocate(ui_index.large);
+            ui_index.large = null;
+            ui_index.large_capacity = 0;
+        }
+    } else {
+        for (int cy = u->indexed.y0; cy <= u->indexed.y1; cy++) {
+            for (int cx = u->indexed.x0; cx <= u->indexed.x1; cx++) {
+                ui_index_bucket_t* b = ui_index_bucket(cx, cy);
+                for (int i = 0; i < b->count; i++) {
+                    if (b->entries[i].u == u) { b->entries[i] = b->entries[--b->count]; break; }
+                }
+                if (b->count == 0) {
+                    deallocate(b->entries);
+                    memset(b, 0, sizeof(*b));
+                }
+            }
+        }
+    }
+    u->indexed.on = false;
+}
+
+static bool ui_is_root(ui_t* u) { return app != null && u == &app->root; }
+
+static bool ui_indexes(ui_t* u) { // children of u belong to the spatial index
+    return !u->scrolls && (u->indexed.on || ui_is_root(u));
+}
+
+static void ui_index_subtree(ui_t* u) {
+    ui_index_insert(u);
+    if (!u->scrolls) {
+        for (ui_t* c = u->children; c != null; c = c->next) { ui_index_subtree(c); }
+    }
+}
+
+static void ui_erase_subtree(ui_t* u) {
+    if (u->indexed.on) { ui_index_erase(u); }
+    if (!u->scrolls) {
+        for (ui_t* c = u->children; c != null; c = c->next) { ui_erase_subtree(c); }
+    }
+}
+
+static bool ui_contains(ui_t* u, float x, float y) { // x, y absolute
+    const rectf_t r = ui.screen_rect(u);
+    return r.x <= x && x < r.x + r.w && r.y <= y && y < r.y + r.h;
+}
+
+static int ui_number(ui_t* u, int n) { // pre-order numbers of ui and its last descendant
+    u->indexed.order = n++;
+    for (ui_t* c = u->children; c != null; c = c->next) { n = ui_number(c, n); }
+    u->indexed.last = n - 1;
+    return n;
+}
+
+static bool ui_precedes(ui_t* a, ui_t* b, bool post_order) {
+    // order of the recursive tree walk: children are visited in list order,
+    // parents before (pre-order) or after (post-order) their descendants.
+    // Both are indexed: numbers are renumbered once after ui.add() to app.root
+    assert(a != b && a->indexed.on && b->indexed.on);
+    if (!ui_index.numbered) { ui_number(&app->root, 0); ui_index.numbered = true; }
+    const int ao = a->indexed.order;
+    const int bo = b->indexed.order;
+    if (!post_order) { return ao < bo; }
+    return (bo < ao && ao <= b->indexed.last) || a->indexed.last < bo; // descendant of b or before b
+}
+
+static void ui_index_visit(float x, float y, void (*visit)(void* that, ui_t* u), void* that) {
+    // visits every indexed widget which absolute bounds contain (x, y)
+    const int cx = (int)floorf(x / UI_INDEX_CELL);
+    const int cy = (int)floorf(y / UI_INDEX_CELL);
+    ui_index_bucket_t* b = ui_index_bucket(cx, cy);
+    for (int i = 0; i < b->count; i++) {
+        ui_index_entry_t* e = &b->entries[i];
+        if (e->x == cx && e->y == cy && ui_contains(e->u, x, y)) { visit(that, e->u); }
+    }
+    for (int i = 0; i < ui_index.large_count; i++) {
+        if (ui_contains(ui_index.large[i], x, y)) { visit(that, ui_index.large[i]); }
+    }
+}
+
+typedef struct ui_hits_s {
+    ui_t* root;
+    float x; // absolute
+    float y;
+    ui_t* hits[UI_INDEX_HITS];
+    int count; // may exceed countof(hits)
+    ui_t* focus;
+    ui_t* focus_hit; // indexed ui focus was found at: focus itself or its scrolling ancestor
+} ui_hits_t;
+
+static void ui_touch_hit(void* that, ui_t* u) {
+    // same widgets as tree walk: visible and every ancestor is visible and contains (x, y)
+    ui_hits_t* h = (ui_hits_t*)that;
+    if (h->count > countof(h->hits)) { return; } // too many: caller falls back to tree walk
+    ui_t* c = u;
+    while (c != h->root && !c->hidden && ui_contains(c, h->x, h->y)) { c = c->parent; }
+    if (c == h->root) {
+        if (h->count < countof(h->hits)) { h->hits[h->count] = u; }
+        h->count++;
+    }
+}
+
+/* Pointer capture: widgets that ui.capture() on TOUCH_DOWN get moves and up
+   of the pointer directly, nothing else is hit tested or visited till up. */
+
+static struct {
+    ui_t* ui[8];
+    bool inside[8]; // last known pointer position relative to ui bounds
+    int count;
+    bool down;      // TOUCH_DOWN is being dispatched: captures are shared
+} ui_captures;
+
+static int ui_capture_index(ui_t* u) {
+    for (int i = 0; i < ui_captures.count; i++) {
+        if (ui_captures.ui[i] == u) { return i; }
+    }
+    return -1;
+}
+
+static void ui_capture(ui_t* u) {
+    if (ui_captures.down) {
+        assertion(ui_captures.count < countof(ui_captures.ui), "too many captures");
+        if (ui_capture_index(u) < 0 && ui_captures.count < countof(ui_captures.ui)) {
+            ui_captures.ui[ui_captures.count] = u;
+            ui_captures.inside[ui_captures.count] = true;
+            ui_captures.count++;
+        }
+    } else if (ui_captures.count != 1 || ui_captures.ui[0] != u) {
+        // exclusive (e.g. scroll started dragging): others see the pointer leave
+        const int i = ui_capture_index(u);
+        const bool inside = i < 0 || ui_captures.inside[i];
+        ui_t* lost[countof(ui_captures.ui)];
+        bool was[countof(ui_captures.ui)];
+        const int n = ui_captures.count;
+        memcpy(lost, ui_captures.ui, sizeof(lost));
+        memcpy(was, ui_captures.inside, sizeof(was));
+        ui_captures.ui[0] = u;
+        ui_captures.inside[0] = inside;
+        ui_captures.count = 1;
+        for (int k = 0; k < n; k++) {
+            if (lost[k] != u && was[k] && lost[k]->enter != null) { lost[k]->enter(lost[k], false); }
+        }
+    }
+}
+
+static void ui_capture_drop(ui_t* u) { // u and its descendants lose the pointer
+    int n = 0;
+    for (int i = 0; i < ui_captures.count; i++) {
+        ui_t* c = ui_captures.ui[i];
+        while (c != null && c != u) { c = c->parent; }
+        if (c == null) {
+            ui_captures.ui[n] = ui_captures.ui[i];
+            ui_captures.inside[n] = ui_captures.inside[i];
+            n++;
+        }
+    }
+    ui_captures.count = n;
+}
+
+static bool ui_dispatch_captured(int touch_action, float x, float y) { // x, y absolute
+    ui_t* captured[countof(ui_captures.ui)];
+    const int n = ui_captures.count;
+    memcpy(captured, ui_captures.ui, sizeof(captured));
+    bool consumed = false;
+    for (int i = 0; i < n; i++) {
+        ui_t* c = captured[i];
+        int k = ui_capture_index(c); // enter() or touch() of others may have taken it away
+        if (k >= 0) {
+            const bool inside = !c->hidden && ui_contains(c, x, y);
+            if (ui_captures.inside[k] != inside) {
+                ui_captures.inside[k] = inside;
+                if (c->enter != null) { c->enter(c, inside); }
+                k = ui_capture_index(c);
+            }
+        }
+        if (k >= 0 && c->touch != null) {
+            const rectf_t r = ui.screen_rect(c);
+            consumed |= c->touch(c, touch_action, x - r.x, y - r.y);
+        }
+    }
+    if (touch_action & TOUCH_UP) { ui_captures.count = 0; }
+    return consumed;
+}
+
+static ui_t* ui_focus_find(ui_t* u, int x, int y) {
+    // first focusable ui containing (x, y) in post-order tree walk (descendants first)
+    ui_t* f = null;
+    for (ui_t* c = u->children; c != null && f == null; c = c->next) { f = ui_focus_find(c, x, y); }
+    if (f == null && u->focusable) {
+        const rectf_t r = ui.screen_rect(u);
+        if (r.x <= x && x < r.x + r.w && r.y <= y && y < r.y + r.h) { f = u; }
+    }
+    return f;
+}
+
+static void ui_focus_hit(void* that, ui_t* u) {
+    ui_hits_t* h = (ui_hits_t*)that;
+    ui_t* f = null;
+    if (u->scrolls) { // not indexed descendants are visited before u
+        for (ui_t* c = u->children; c != null && f == null; c = c->next) {
+            f = ui_focus_find(c, (int)h->x, (int)h->y);
+        }
+    }
+    if (f == null && u->focusable) { f = u; }
+    if (f != null && (h->focus == null || ui_precedes(u, h->focus_hit, true))) {
+        h->focus = f;
+        h->focus_hit = u;
+    }
+}
+
 static void ui_add(ui_t* container, ui_t* child, float x, float y, float w, float h) {
     assert(child != null);
     assertion(child->parent == null && child->next == null, "Reparenting of a ui is not supported. Can be implemented if needed");
@@ -30,6 +371,12 @@ static void ui_add(ui_t* container, ui_t* child, float x, float y, float w, floa
     child->w = w;
     child->h = h;
     child->parent = container;
+    if (child->store != null) { ui_store_changed(child); } // before ui_dirty() reads the arrays
+    ui_dirty(child);
+    if (ui_indexes(container)) {
+        ui_index_subtree(child);
+        ui_index.numbered = false; // removal keeps the order of the remaining ui
+    }
 }
 
 static void ui_remove(ui_t* container, ui_t* child) {
@@ -37,9 +384,13 @@ static void ui_remove(ui_t* container, ui_t* child) {
     ui_t* c = container->children;
     while (c != null) {
         if (c == child) {
+            if (ui_captures.count > 0) { ui_capture_drop(child); }
+            ui_erase_subtree(child);
             *prev = child->next;
             child->next = null;
             child->parent = null;
+            if (child->store != null) { ui_store_changed(child); } // before ui_dirty() reads the arrays
+            ui_dirty(child);
             return;
         }
         prev = &c->next;
@@ -48,6 +399,43 @@ static void ui_remove(ui_t* container, ui_t* child) {
     assertion(false, "control not found");
 }
 
+static void ui_set_bounds(ui_t* u, float x, float y, float w, float h) {
+    const bool moved = u->x != x || u->y != y;
+    const bool rooted = u->indexed.on || ui_is_root(u);
+    if (rooted && moved) {
+        ui_erase_subtree(u); // absolute position of all descendants changes
+    } else if (u->indexed.on) {
+        ui_index_erase(u);
+    }
+    u->x = x;
+    u->y = y;
+    u->w = w;
+    u->h = h;
+    if (moved) {
+        ui_dirty(u);
+    } else if (!u->dirty) { // size does not affect descendants
+        u->screen.w = w;
+        u->screen.h = h;
+    }
+    if (rooted) {
+        if (!ui_is_root(u)) {
+            if (moved) { ui_index_subtree(u); } else { ui_index_insert(u); }
+        } else if (moved) {
+            for (ui_t* c = u->children; c != null; c = c->next) { ui_index_subtree(c); }
+        }
+    }
+    if (u->store != null) { ui_store_moved(u); }
+}
+
+static void ui_hide(ui_t* u, bool hidden) {
+    if (u->hidden != hidden) {
+        u->hidden = hidden;
+        if (hidden && ui_captures.count > 0) { ui_capture_drop(u); }
+        ui.invalidate(u); // bounds are redrawn with or without the ui
+        if (u->store != null) { ui_store_moved(u); }
+    }
+}
+
 static void ui_init(ui_t* u, ui_t* parent, void* that, float x, float y, float w, float h) {
     assert(u->a == null);
     assert(u->next == null);
@@ -72,11 +460,58 @@ static void ui_done(ui_t* u) {
     memset(u, 0, sizeof(*u));
 }
 
+static bool ui_clipped(ui_t* u) { // true if ui is outside of the frame clip rectangle
+    const rectf_t* k = &dc.clipping;
+    if (k->w <= 0 || k->h <= 0) { return false; }
+    const rectf_t r = ui.screen_rect(u);
+    return r.x + r.w <= k->x || k->x + k->w <= r.x || r.y + r.h <= k->y || k->y + k->h <= r.y;
+}
+
+static void ui_draw_child(ui_t* c, bool decor) {
+    if (!c->hidden && !c->decor == !decor && (c->invalid || !ui_clipped(c))) {
+        c->draw(c);
+        c->invalid = false;
+    }
+}
+
+static void ui_draw_pooled(ui_store_t* s, int first, int end, bool decor) {
+    // children of the range culled over dense arrays, ui_t is read only for drawn ones
+    const rectf_t k = dc.clipping;
+    const bool clipping = k.w > 0 && k.h > 0;
+    rectf_t o = ui.screen_rect(s->root);
+    o.x -= s->root->offset.x;
+    o.y -= s->root->offset.y;
+    const int changes = s->changes;
+    int i = first;
+    while (i < end) {
+        const byte f = s->flags[i];
+        if ((f & UI_STORE_HIDDEN) == 0 && !(f & UI_STORE_DECOR) == !decor) {
+            const float x = o.x + s->xy[i].x;
+            const float y = o.y + s->xy[i].y;
+            const bool clipped = clipping && (x + s->bounds[i].w <= k.x || k.x + k.w <= x ||
+                                              y + s->bounds[i].h <= k.y || k.y + k.h <= y);
+            ui_t* c = s->ui[i];
+            if (!clipped || c->invalid) {
+                c->draw(c);
+                c->invalid = false;
+                if (s->changes != changes) { // draw() changed the tree: the rest of siblings by pointers
+                    for (c = c->next; c != null; c = c->next) { ui_draw_child(c, decor); }
+                    return;
+                }
+            }
+        }
+        i = s->end[i];
+    }
+}
+
 static void ui_draw_childs(ui_t* u, bool decor) {
-    ui_t* c = u->children;
-    while (c != null) {
-        if (!c->hidden && !c->decor == !decor) { c->draw(c); }
-        c = c->next;
+    int first = 0;
+    int end = 0;
+    ui_store_t* s = ui_store_subtree(u, true, &first, &end);
+    if (s != null) {
+        ui_draw_pooled(s, first, end, decor);
+    } else {
+        for (ui_t* c = u->children; c != null; c = c->next) { ui_draw_child(c, decor); }
     }
 }
 
@@ -91,56 +526,172 @@ static void ui_draw(ui_t* u) {
 
 static bool ui_touch(ui_t* u, int touch_action, float x, float y) { return false; }
 
-static void ui_screen_touch(ui_t* u, int touch_action, float x, float y) { }
+static void ui_enter(ui_t* u, bool inside) { }
 
-static bool ui_dispatch_touch(ui_t* u, int touch_action, float x, float y) {
+static bool ui_dispatch_touch_tree(ui_t* u, int touch_action, float x, float y);
+
+static bool ui_dispatch_pooled(ui_store_t* s, int touch_action, float x, float y) {
+    // hits of the whole store in pre-order from dense arrays, x, y relative to the root
+    ui_t* hits[UI_INDEX_HITS];
+    pointf_t xy[UI_INDEX_HITS]; // touch() may reorder the arrays: local coordinates first
+    const int n = ui_store_hits(s, x, y, hits, countof(hits));
+    if (n > countof(hits)) { return false; }
+    for (int i = 0; i < n; i++) {
+        xy[i] = (pointf_t){ x - s->xy[hits[i]->position].x, y - s->xy[hits[i]->position].y };
+    }
+    for (int i = 0; i < n; i++) {
+        if (hits[i]->touch != null) { hits[i]->touch(hits[i], touch_action, xy[i].x, xy[i].y); }
+    }
+    return true;
+}
+
+static bool ui_dispatch_touch_tree(ui_t* u, int touch_action, float x, float y) {
+    x += u->offset.x; // children coordinates
+    y += u->offset.y;
     ui_t* c = u->children;
     bool consumed = false;
     while (c != null && !consumed) {
         if (!c->hidden && c->x <= x && x < c->x + c->w && c->y <= y && y < c->y + c->h) {
             if (c->touch != null) { c->touch(c, touch_action, x - c->x, y - c->y); }
-            consumed = ui_dispatch_touch(c, touch_action, x - c->x, y - c->y);
+            int first = 0;
+            int end = 0;
+            ui_store_t* s = c->store == null ? ui_store_subtree(c, true, &first, &end) : null;
+            const float px = x - c->x + c->offset.x;
+            const float py = y - c->y + c->offset.y;
+            if (s == null || !ui_dispatch_pooled(s, touch_action, px, py)) {
+                consumed = ui_dispatch_touch_tree(c, touch_action, x - c->x, y - c->y);
+            }
         }
         c = c->next;
     }
     return consumed;
 }
 
-static void ui_dispatch_screen_touch(ui_t* u, int touch_action, float x, float y) {
-    ui_t* c = u->children;
-    while (c != null) { // do it even for hidden widgets
-        if (c->screen_touch != null) { c->screen_touch(c, touch_action, x, y); }
-        ui_dispatch_screen_touch(c, touch_action, x, y);
-        c = c->next;
+static bool ui_dispatch_hits(ui_t* u, int touch_action, float x, float y) {
+    if (!ui_is_root(u) || ui_index.failed) { return ui_dispatch_touch_tree(u, touch_action, x, y); }
+    ui_hits_t h = { .root = u, .x = x + u->x, .y = y + u->y }; // absolute
+    ui_index_visit(h.x, h.y, ui_touch_hit, &h);
+    if (h.count > countof(h.hits)) { return ui_dispatch_touch_tree(u, touch_action, x, y); }
+    for (int i = 1; i < h.count; i++) { // insertion sort in tree walk order, count is small
+        ui_t* c = h.hits[i];
+        int j = i;
+        while (j > 0 && ui_precedes(c, h.hits[j - 1], false)) { h.hits[j] = h.hits[j - 1]; j--; }
+        h.hits[j] = c;
     }
+    for (int i = 0; i < h.count; i++) {
+        ui_t* c = h.hits[i];
+        const rectf_t r = ui.screen_rect(c);
+        if (c->touch != null) { c->touch(c, touch_action, h.x - r.x, h.y - r.y); }
+        if (c->scrolls) { ui_dispatch_touch_tree(c, touch_action, h.x - r.x, h.y - r.y); } // not indexed
+    }
+    return false; // as tree walk: return value of touch() does not stop dispatch
+}
+
+static bool ui_dispatch_touch(ui_t* u, int touch_action, float x, float y) {
+    if (ui_captures.count > 0 && (touch_action & (TOUCH_MOVE | TOUCH_UP)) != 0) {
+        const rectf_t r = ui.screen_rect(u);
+        return ui_dispatch_captured(touch_action, r.x + x, r.y + y);
+    }
+    if (touch_action & TOUCH_DOWN) {
+        while (ui_captures.count > 0) { // up was lost (e.g. application paused)
+            ui_t* c = ui_captures.ui[--ui_captures.count];
+            if (ui_captures.inside[ui_captures.count] && c->enter != null) { c->enter(c, false); }
+        }
+        ui_captures.down = true;
+    }
+    const bool consumed = ui_dispatch_hits(u, touch_action, x, y);
+    ui_captures.down = false;
+    return consumed;
 }
 
 static bool ui_keyboard(ui_t* u, int flags, int ch) { return false; }
 
 static void ui_focus(ui_t* u, bool gain) { }
 
+static rectf_t ui_frame_rect(ui_t* u) { // cached bounds relative to children of u->frame
+    if (u->parent == null) { return (rectf_t){u->x, u->y, u->w, u->h}; }
+    if (u->dirty) {
+        ui_t* p = u->parent;
+        if (p->scrolls) {
+            u->frame = p;
+            u->screen = (rectf_t){u->x, u->y, u->w, u->h};
+        } else {
+            const rectf_t r = ui_frame_rect(p); // ancestors first: clean ui has clean ancestors
+            u->frame = p->parent != null ? p->frame : null;
+            u->screen = (rectf_t){r.x + u->x, r.y + u->y, u->w, u->h};
+        }
+        u->dirty = false;
+    }
+    return u->screen;
+}
+
+static rectf_t ui_screen_rect(ui_t* u) {
+    rectf_t r = ui_frame_rect(u);
+    if (u->parent != null && u->frame != null) { // scrolled: offset is applied on every call
+        const rectf_t f = ui_screen_rect(u->frame);
+        r.x += f.x - u->frame->offset.x;
+        r.y += f.y - u->frame->offset.y;
+    }
+    #ifdef DEBUG
+    const rectf_t w = ui_screen_rect_walk(u);
+    assertion(r.x == w.x && r.y == w.y && r.w == w.w && r.h == w.h,
+              "stale screen rect: x, y, w, h of ui or its ancestor changed without ui.set_bounds()");
+    #endif
+    return r;
+}
+
+static void ui_scroll(ui_t* u, float x, float y) {
+    if (!u->scrolls) { // once: descendants leave the index and are cached relative to u
+        for (ui_t* c = u->children; c != null; c = c->next) { ui_erase_subtree(c); }
+        u->scrolls = true;
+        for (ui_t* c = u->children; c != null; c = c->next) { ui_dirty(c); }
+    }
+    u->offset = (pointf_t){x, y};
+}
+
+static void ui_invalidate(ui_t* u) {
+    const rectf_t r = ui_screen_rect(u);
+    if (r.w > 0 && r.h > 0) {
+        rectf_t* d = &app->invalid; // union with previously invalidated bounds
+        if (d->w <= 0 || d->h <= 0) {
+            *d = r;
+        } else {
+            const float x1 = max(d->x + d->w, r.x + r.w);
+            const float y1 = max(d->y + d->h, r.y + r.h);
+            d->x = min(d->x, r.x);
+            d->y = min(d->y, r.y);
+            d->w = x1 - d->x;
+            d->h = y1 - d->y;
+        }
+        // all the way up: invalid is cleared only on drawn ui, hidden ui and
+        // app.root keep it set and cannot stop the propagation
+        for (ui_t* p = u; p != null; p = p->parent) { p->invalid = true; }
+        sys.invalidate(app);
+    }
+}
+
 static pointf_t ui_screen_xy(ui_t* u) {
-    pointf_t pt = {u->x, u->y};
-    ui_t* p = u->parent;
-    while (p != null) { pt.x += p->x; pt.y += p->y; p = p->parent; }
-    return pt;
+    const rectf_t r = ui_screen_rect(u);
+    return (pointf_t){r.x, r.y};
+}
+
+static bool ui_set_focus_tree(ui_t* u, int x, int y) {
+    assert(u != null);
+    ui_t* f = ui_focus_find(u, x, y);
+    if (f != null) { sys.focus(f->a, f); }
+    return f != null;
 }
 
 static bool ui_set_focus(ui_t* u, int x, int y) {
     assert(u != null);
-    ui_t* child = u->children;
-    bool focus_was_set = false;
-    while (child != null && !focus_was_set) {
-        assert(child != u);
-        focus_was_set = ui_set_focus(child, x, y);
-        child = child->next;
-    }
-    if (!focus_was_set && u->focusable) {
-        const pointf_t pt = ui.screen_xy(u);
-        focus_was_set = pt.x <= x && x < pt.x + u->w && pt.y <= y && y < pt.y + u->h;
-        if (focus_was_set) { sys.focus(u->a, u); }
+    if (!ui_is_root(u) || ui_index.failed) { return ui_set_focus_tree(u, x, y); }
+    ui_hits_t h = { .root = u, .x = x, .y = y };
+    ui_index_visit(x, y, ui_focus_hit, &h);
+    if (h.focus == null && u->focusable && u->x <= x && x < u->x + u->w && u->y <= y && y < u->y + u->h) {
+        h.focus = u;
     }
-    return focus_was_set;
+    if (h.focus != null) { sys.focus(h.focus->a, h.focus); }
+    return h.focus != null;
 }
 
 const ui_interface_t ui = {
@@ -148,17 +699,22 @@ const ui_interface_t ui = {
     ui_done,
     ui_add,
     ui_remove,
+    ui_set_bounds,
+    ui_hide,
     ui_screen_xy,
+    ui_screen_rect,
+    ui_invalidate,
     ui_set_focus,
     ui_dispatch_touch,
-    ui_dispatch_screen_touch
+    ui_capture,
+    ui_scroll
 };
 
 const ui_t ui_proto = {
     ui_draw,
     ui_draw_children,
     ui_touch,
-    ui_screen_touch,
+    ui_enter,
     ui_keyboard,
     ui_focus
 };
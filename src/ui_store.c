@@ -0,0 +1,222 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "ui_store.h"
+
+begin_c
+
+enum { UI_STORE_BLOCK = 256 }; // elements per pool block
+
+void ui_store_init(ui_store_t* s, ui_t* root) {
+    memset(s, 0, sizeof(*s));
+    s->root = root;
+}
+
+static int ui_store_grow(ui_store_t* s) { // adds pool block and grows arrays
+    const int n = s->capacity + UI_STORE_BLOCK;
+    ui_t** blocks = (ui_t**)reallocate(s->blocks, (s->blocks_count + 1) * sizeof(ui_t*));
+    if (blocks != null) { s->blocks = blocks; }
+    ui_t* block = blocks != null ? (ui_t*)allocate(UI_STORE_BLOCK * sizeof(ui_t)) : null;
+    int r = block != null ? 0 : ENOMEM;
+    #define ui_store_array(a) \
+        if (r == 0) { \
+            void* p = reallocate(s->a, n * sizeof(*s->a)); \
+            if (p != null) { s->a = p; } else { r = ENOMEM; } \
+        }
+    ui_store_array(ui)
+    ui_store_array(bounds)
+    ui_store_array(xy)
+    ui_store_array(parent)
+    ui_store_array(end)
+    ui_store_array(flags)
+    ui_store_array(kind)
+    #undef ui_store_array
+    if (r == 0) {
+        s->blocks[s->blocks_count++] = block;
+        for (int i = UI_STORE_BLOCK - 1; i >= 0; i--) { // lower addresses are handed out first
+            block[i].next = s->free;
+            s->free = &block[i];
+        }
+        s->capacity = n;
+    } else {
+        deallocate(block); // arrays that did grow are simply larger than capacity
+    }
+    return r;
+}
+
+ui_t* ui_store_allocate(ui_store_t* s, ui_t* parent, void* that, float x, float y, float w, float h) {
+    assertion(parent == s->root || parent->store == s, "parent must be the root or in the same store");
+    int r = s->free != null ? 0 : ui_store_grow(s);
+    ui_t* u = null;
+    if (r == 0) {
+        u = s->free;
+        s->free = u->next;
+        memset(u, 0, sizeof(*u));
+        ui.init(u, parent, that, x, y, w, h);
+        u->store = s;
+        ui_store_changed(u);
+    }
+    errno = r;
+    return u;
+}
+
+void ui_store_deallocate(ui_t* u) {
+    ui_store_t* s = u->store;
+    assertion(u->children == null, "deallocate children first");
+    ui.done(u); // remove()-s from parent and zeroes
+    u->next = s->free;
+    s->free = u;
+}
+
+void ui_store_dispose(ui_store_t* s) {
+    for (int b = 0; b < s->blocks_count; b++) {
+        for (int i = 0; i < UI_STORE_BLOCK; i++) {
+            ui_t* u = &s->blocks[b][i];
+            if (u->store == s && u->parent != null) { ui.remove(u->parent, u); }
+        }
+    }
+    for (int b = 0; b < s->blocks_count; b++) { deallocate(s->blocks[b]); }
+    deallocate(s->blocks);
+    deallocate(s->ui);
+    deallocate(s->bounds);
+    deallocate(s->xy);
+    deallocate(s->parent);
+    deallocate(s->end);
+    deallocate(s->flags);
+    deallocate(s->kind);
+    memset(s, 0, sizeof(*s));
+}
+
+static byte ui_store_flags(ui_t* u) {
+    return (u->hidden ? UI_STORE_HIDDEN : 0) | (u->decor ? UI_STORE_DECOR : 0) |
+           (u->focusable ? UI_STORE_FOCUSABLE : 0);
+}
+
+static void ui_store_visit(ui_store_t* s, ui_t* u, int parent) {
+    for (ui_t* c = u->children; c != null; c = c->next) {
+        s->mixed |= c->store != s;
+        if (c->store == s) { // not pooled children are skipped with their subtrees
+            const int i = s->count++;
+            assert(i < s->capacity);
+            s->ui[i] = c;
+            s->bounds[i] = (rectf_t){c->x, c->y, c->w, c->h};
+            s->xy[i] = parent < 0 ? (pointf_t){c->x, c->y} :
+                       (pointf_t){s->xy[parent].x + c->x, s->xy[parent].y + c->y};
+            s->parent[i] = parent;
+            s->flags[i] = ui_store_flags(c);
+            s->kind[i] = (byte)c->kind;
+            c->position = i;
+            ui_store_visit(s, c, i);
+            s->end[i] = s->count;
+        }
+    }
+}
+
+static void ui_store_order(ui_store_t* s) {
+    if (!s->ordered) {
+        s->count = 0;
+        s->mixed = false;
+        ui_store_visit(s, s->root, -1);
+        s->ordered = true;
+    }
+}
+
+static bool ui_store_ordered(ui_store_t* s, ui_t* u) { // u is in the arrays
+    // pooled descendants of removed elements keep stale positions
+    return s->ordered && 0 <= u->position && u->position < s->count && s->ui[u->position] == u;
+}
+
+ui_store_t* ui_store_subtree(ui_t* u, bool order, int* first, int* end) {
+    ui_store_t* s = u->store != null ? u->store : (u->children != null ? u->children->store : null);
+    if (s != null && u->store == null && s->root != u) { s = null; }
+    if (s != null && order) { ui_store_order(s); }
+    if (s != null && (s->mixed || (u->store != null ? !ui_store_ordered(s, u) : !s->ordered))) { s = null; }
+    if (s != null) {
+        *first = u->store != null ? u->position + 1 : 0;
+        *end = u->store != null ? s->end[u->position] : s->count;
+    }
+    return s;
+}
+
+void ui_store_changed(ui_t* u) {
+    u->store->ordered = false;
+    u->store->changes++;
+}
+
+void ui_store_moved(ui_t* u) {
+    ui_store_t* s = u->store;
+    if (ui_store_ordered(s, u)) {
+        const int i = u->position;
+        s->bounds[i] = (rectf_t){u->x, u->y, u->w, u->h};
+        s->flags[i] = ui_store_flags(u);
+        for (int j = i; j < s->end[i]; j++) { // descendants follow in pre-order
+            const int p = s->parent[j];
+            s->xy[j] = p < 0 ? (pointf_t){s->bounds[j].x, s->bounds[j].y} :
+                       (pointf_t){s->xy[p].x + s->bounds[j].x, s->xy[p].y + s->bounds[j].y};
+        }
+    }
+}
+
+#ifdef DEBUG
+
+static void ui_store_check(ui_store_t* s, int i) {
+    ui_t* u = s->ui[i];
+    assertion(u->x == s->bounds[i].x && u->y == s->bounds[i].y &&
+              u->w == s->bounds[i].w && u->h == s->bounds[i].h && s->flags[i] == ui_store_flags(u),
+              "stale store: bounds or flags changed without ui.set_bounds() or ui.hide()");
+}
+
+#else
+
+#define ui_store_check(s, i)
+
+#endif
+
+int ui_store_hits(ui_store_t* s, float x, float y, ui_t** hits, int n) {
+    ui_store_order(s);
+    int count = 0;
+    int i = 0;
+    while (i < s->count) {
+        ui_store_check(s, i);
+        const float ux = s->xy[i].x;
+        const float uy = s->xy[i].y;
+        if ((s->flags[i] & UI_STORE_HIDDEN) == 0 &&
+            ux <= x && x < ux + s->bounds[i].w && uy <= y && y < uy + s->bounds[i].h) {
+            if (count < n) { hits[count] = s->ui[i]; }
+            count++;
+            i++;
+        } else {
+            i = s->end[i]; // tree walk does not descend into it either
+        }
+    }
+    return count;
+}
+
+int ui_store_cull(ui_store_t* s, rectf_t r, ui_t** visible, int n) {
+    ui_store_order(s);
+    int count = 0;
+    int i = 0;
+    while (i < s->count) {
+        ui_store_check(s, i);
+        const float ux = s->xy[i].x;
+        const float uy = s->xy[i].y;
+        if ((s->flags[i] & UI_STORE_HIDDEN) == 0 &&
+            ux < r.x + r.w && r.x < ux + s->bounds[i].w && uy < r.y + r.h && r.y < uy + s->bounds[i].h) {
+            if (count < n) { visible[count] = s->ui[i]; }
+            count++;
+            i++;
+        } else {
+            i = s->end[i]; // as ui draw_children() clipped ui descendants are not drawn
+        }
+    }
+    return count;
+}
+
+end_c
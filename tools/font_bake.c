@@ -0,0 +1,134 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "app.h"
+#include "font.h"
+
+/* Offline font atlas baking for Linux host. Builds the same atlas as device
+   would (font_load_asset() with stbtt_PackFontRange or font_load_asset_sdf())
+   and writes it as "*.fnt" asset loadable by font_load_baked().
+   Build from the repository root:
+       gcc -std=gnu11 -O2 -Iinc -Iext tools/font_bake.c src/font.c src/face.c src/glyph_cache.c \
+           src/text_cache.c src/raster.c src/tasks.c src/lz4.c src/stb_font.c src/rt.c -lm -lpthread \
+           -o font_bake
+   Usage:
+       font_bake [-sdf] font.ttf height_in_pixels from count font.fnt
+   e.g.:
+       font_bake -sdf apk/assets/liberation-mono-bold-ascii.ttf 32 32 98 \
+           apk/assets/liberation-mono-bold-ascii.fnt */
+
+begin_c
+
+static void* asset_map(app_t* a, const char* name, const void* *data, int *bytes) {
+    void* asset = null;
+    FILE* f = fopen(name, "rb");
+    if (f != null) {
+        fseek(f, 0, SEEK_END);
+        *bytes = (int)ftell(f);
+        fseek(f, 0, SEEK_SET);
+        asset = allocate(*bytes);
+        if (asset != null && fread(asset, 1, *bytes, f) != (size_t)*bytes) {
+            deallocate(asset);
+            asset = null;
+        }
+        fclose(f);
+    }
+    *data = asset;
+    return asset;
+}
+
+static void asset_unmap(app_t* a, void* asset, const void* data, int bytes) {
+    deallocate(asset);
+}
+
+static int logln(int level, const char* tag, const char* location, const char* format, va_list vl) {
+    fprintf(stderr, "%s", location);
+    vfprintf(stderr, format, vl);
+    fprintf(stderr, "\n");
+    return 0;
+}
+
+const sys_t sys = {
+    .asset_map = asset_map,
+    .asset_unmap = asset_unmap,
+    .logln = logln
+};
+
+// there is no GL context offline: font atlas is never uploaded
+
+int texture_allocate_and_update(texture_t* b) { return ENOSYS; }
+int texture_update_rows(texture_t* b, int y, int h) { return ENOSYS; }
+int texture_linear(texture_t* b) { return ENOSYS; }
+int texture_deallocate(texture_t* b) { b->ti = 0; return 0; }
+
+void texture_dispose(texture_t* b) {
+    deallocate(b->data);
+    memset(b, 0, sizeof(*b));
+}
+
+static int write_baked(font_t* f, const char* name) {
+    font_baked_header_t h = {};
+    memcpy(h.magic, FONT_BAKED_MAGIC, sizeof(h.magic));
+    h.height = f->height;
+    h.from = f->from;
+    h.count = f->count;
+    h.em = f->em;
+    h.ascent = f->ascent;
+    h.descent = f->descent;
+    h.baseline = f->baseline;
+    h.spread = f->sdf ? f->spread : 0;
+    h.w = f->atlas.w;
+    h.h = f->atlas.h;
+    h.kerning = f->kerning_capacity;
+    assert(f->atlas.comp == 1);
+    int r = 0;
+    FILE* file = fopen(name, "wb");
+    if (file == null) {
+        r = errno;
+    } else {
+        const size_t chars = f->count * sizeof(stbtt_packedchar);
+        const size_t pairs = f->kerning_capacity * sizeof(font_kerning_pair_t);
+        const size_t pixels = (size_t)f->atlas.w * f->atlas.h;
+        if (fwrite(&h, 1, sizeof(h), file) != sizeof(h) ||
+            fwrite(f->chars, 1, chars, file) != chars ||
+            (pairs > 0 && fwrite(f->kerning, 1, pairs, file) != pairs) ||
+            fwrite(f->atlas.data, 1, pixels, file) != pixels) {
+            r = errno;
+        }
+        if (fclose(file) != 0 && r == 0) { r = errno; }
+    }
+    return r;
+}
+
+int main(int argc, const char* argv[]) {
+    const bool sdf = argc > 1 && strcmp(argv[1], "-sdf") == 0;
+    if (sdf) { argc--; argv++; }
+    if (argc != 6) {
+        fprintf(stderr, "usage: font_bake [-sdf] font.ttf height_in_pixels from count font.fnt\n");
+        return EINVAL;
+    }
+    const int hpx = atoi(argv[2]);
+    const int from = atoi(argv[3]);
+    const int count = atoi(argv[4]);
+    font_t f = {};
+    int r = sdf ? font_load_asset_sdf(&f, null, argv[1], hpx, from, count) :
+                  font_load_asset(&f, null, argv[1], hpx, from, count);
+    if (r == 0) { r = write_baked(&f, argv[5]); }
+    if (r == 0) {
+        printf("%s: %dpx [%d..%d] atlas %dx%d%s\n", argv[5], hpx, from, from + count - 1,
+               f.atlas.w, f.atlas.h, sdf ? " sdf" : "");
+    } else {
+        fprintf(stderr, "failed to bake \"%s\": %s\n", argv[1], strerror(r));
+    }
+    font_dispose(&f);
+    return r;
+}
+
+end_c
@@ -0,0 +1,113 @@
+/* Copyright 2020 "Leo" Dmitry Kuznetsov https://leok7v.github.io/
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+#include "app.h"
+#include "raster.h"
+#include "tasks.h"
+
+/* Glyph rasterizers benchmark for Linux host: rasterizes every glyph of
+   the font in [from..from + count) at 12..96 pixels with
+   stbtt_MakeGlyphBitmap() and raster_glyph() and reports time and
+   the largest pixel difference.
+   Build from the repository root:
+       gcc -std=gnu11 -O2 -Iinc -Iext tools/raster_bench.c src/raster.c src/tasks.c \
+           src/stb_font.c src/rt.c -lm -lpthread -o raster_bench
+   Usage:
+       raster_bench font.ttf [from count]
+   e.g.:
+       raster_bench apk/assets/liberation-mono-bold-ascii.ttf 32 95 */
+
+begin_c
+
+static int logln(int level, const char* tag, const char* location, const char* format, va_list vl) {
+    fprintf(stderr, "%s", location);
+    vfprintf(stderr, format, vl);
+    fprintf(stderr, "\n");
+    return 0;
+}
+
+const sys_t sys = { .logln = logln };
+
+enum { REPEAT = 10 }; // every size is rasterized REPEAT times for stable timing
+
+static void* load(const char* name, int *bytes) {
+    void* data = null;
+    FILE* f = fopen(name, "rb");
+    if (f != null) {
+        fseek(f, 0, SEEK_END);
+        *bytes = (int)ftell(f);
+        fseek(f, 0, SEEK_SET);
+        data = allocate(*bytes);
+        if (data != null && fread(data, 1, *bytes, f) != (size_t)*bytes) {
+            deallocate(data);
+            data = null;
+        }
+        fclose(f);
+    }
+    return data;
+}
+
+static uint64_t rasterize(stbtt_fontinfo* fi, float scale, int from, int count, byte* pixels, bool stb) {
+    const uint64_t start = tasks_time_ns();
+    for (int i = 0; i < count; i++) {
+        const int glyph = stbtt_FindGlyphIndex(fi, from + i);
+        int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+        stbtt_GetGlyphBitmapBox(fi, glyph, scale, scale, &x0, &y0, &x1, &y1);
+        byte* out = pixels + (size_t)i * 128 * 128;
+        if (x1 - x0 > 0 && y1 - y0 > 0) {
+            if (stb) {
+                stbtt_MakeGlyphBitmap(fi, out, x1 - x0, y1 - y0, 128, scale, scale, glyph);
+            } else {
+                raster_glyph(fi, out, x1 - x0, y1 - y0, 128, scale, glyph);
+            }
+        }
+    }
+    return tasks_time_ns() - start;
+}
+
+int main(int argc, const char* argv[]) {
+    if (argc != 2 && argc != 4) {
+        fprintf(stderr, "usage: raster_bench font.ttf [from count]\n");
+        return EINVAL;
+    }
+    int bytes = 0;
+    void* ttf = load(argv[1], &bytes);
+    stbtt_fontinfo fi = {};
+    if (ttf == null || !stbtt_InitFont(&fi, ttf, 0)) {
+        fprintf(stderr, "failed to load \"%s\"\n", argv[1]);
+        return EINVAL;
+    }
+    const int from = argc == 4 ? atoi(argv[2]) : 32;
+    const int count = argc == 4 ? atoi(argv[3]) : 95;
+    const int sizes[] = { 12, 16, 24, 32, 48, 64, 96 };
+    byte* a = (byte*)allocate((size_t)count * 128 * 128); // 128 x 128 cell per glyph
+    byte* b = (byte*)allocate((size_t)count * 128 * 128);
+    printf("%s [%d..%d]\n", argv[1], from, from + count - 1);
+    printf("  px     stbtt    raster  speedup  max diff\n");
+    for (int i = 0; i < countof(sizes) && a != null && b != null; i++) {
+        const float scale = stbtt_ScaleForPixelHeight(&fi, sizes[i]);
+        uint64_t stb = 0;
+        uint64_t acc = 0;
+        for (int k = 0; k < REPEAT; k++) {
+            stb += rasterize(&fi, scale, from, count, a, true);
+            acc += rasterize(&fi, scale, from, count, b, false);
+        }
+        int diff = 0;
+        for (size_t j = 0; j < (size_t)count * 128 * 128; j++) { diff = max(diff, abs(a[j] - b[j])); }
+        printf("%4d %7.2fms %7.2fms %7.2fx %9d\n", sizes[i], stb / 1e6 / REPEAT, acc / 1e6 / REPEAT,
+               (double)stb / acc, diff);
+    }
+    deallocate(b);
+    deallocate(a);
+    deallocate(ttf);
+    return 0;
+}
+
+end_c